@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+ws:// vs wss:// relay transport benchmark
+Samples /metrics on a headless build (esp32-s3-n16r8v-headless, port 9100)
+at the start and end of a run and reports the relay link timings that
+carry a transport label, so the cost of TLS can be compared on the same
+relay and network.
+
+Procedure:
+  1. Run a relay on the LAN reachable as ws:// and wss:// (same host).
+  2. Point the signer at ws://... and add the relay's address to the ws://
+     allow-list. Drive requests from a NIP-46 client through the relay
+     (the loopback soak bypasses the relay, so it does not count); an
+     idle run still compares keepalive pings and the client loop cost.
+  3. python3 bench_transport.py http://<device>:9100/metrics ws
+  4. Switch the signer to wss://... and repeat with "wss".
+Each run appends one row to the output table (default
+benchmarking-scores/02 ws vs wss.csv).
+
+Usage:
+  python3 bench_transport.py <metrics url> <ws|wss> [seconds] [output]
+"""
+
+import re
+import sys
+import time
+import urllib.request
+from pathlib import Path
+
+DEFAULT_SECONDS = 300
+DEFAULT_OUTPUT = Path(__file__).resolve().parent / "benchmarking-scores" / "02 ws vs wss.csv"
+
+SAMPLE = re.compile(r'^([a-z_]+)(?:\{([^}]*)\})? (\S+)$')
+
+COLUMNS = [
+    ("Transport", 9), ("Seconds", 7), ("Requests", 8), ("Handshake(ms)", 13),
+    ("RTT(ms)", 7), ("RTT max(ms)", 11), ("Send(us)", 8), ("Loop(us)", 8), ("Loop CPU(%)", 11),
+]
+
+
+def scrape(url):
+    """Samples keyed by (name, frozenset of labels)"""
+    with urllib.request.urlopen(url, timeout=10) as response:
+        text = response.read().decode()
+    samples = {}
+    for line in text.splitlines():
+        match = SAMPLE.match(line)
+        if not match:
+            continue
+        name, labels, value = match.groups()
+        label_set = frozenset(re.findall(r'(\w+)="([^"]*)"', labels or ""))
+        samples[(name, label_set)] = float(value)
+    return samples
+
+
+def _value(samples, name, **labels):
+    return samples.get((name, frozenset(labels.items())), 0.0)
+
+
+def _delta_mean(before, after, family, transport):
+    count = _value(after, family + "_count", transport=transport) - _value(before, family + "_count", transport=transport)
+    total = _value(after, family + "_sum", transport=transport) - _value(before, family + "_sum", transport=transport)
+    return total / count if count > 0 else 0.0
+
+
+def _requests(samples):
+    return sum(value for (name, _), value in samples.items() if name == "signer_requests_total")
+
+
+def main():
+    if len(sys.argv) < 3 or sys.argv[2] not in ("ws", "wss"):
+        print(__doc__)
+        return 1
+    url = sys.argv[1]
+    transport = sys.argv[2]
+    seconds = int(sys.argv[3]) if len(sys.argv) > 3 else DEFAULT_SECONDS
+    output = Path(sys.argv[4]) if len(sys.argv) > 4 else DEFAULT_OUTPUT
+
+    before = scrape(url)
+    print(f"Sampling {transport} for {seconds} s...")
+    time.sleep(seconds)
+    after = scrape(url)
+
+    # Handshakes are labelled by verification mode as well; take whichever ran
+    handshake_count = 0.0
+    handshake_sum = 0.0
+    for (name, labels), value in after.items():
+        if name == "signer_relay_handshake_duration_ms_count" and ("transport", transport) in labels:
+            handshake_count += value - before.get((name, labels), 0.0)
+        if name == "signer_relay_handshake_duration_ms_sum" and ("transport", transport) in labels:
+            handshake_sum += value - before.get((name, labels), 0.0)
+
+    loop_sum = _value(after, "signer_relay_loop_duration_us_sum", transport=transport) - _value(before, "signer_relay_loop_duration_us_sum", transport=transport)
+    row = [
+        transport,
+        str(seconds),
+        str(int(_requests(after) - _requests(before))),
+        f"{handshake_sum / handshake_count:.0f}" if handshake_count > 0 else "-",
+        f"{_delta_mean(before, after, 'signer_relay_rtt_ms', transport):.1f}",
+        f"{_value(after, 'signer_relay_rtt_ms', transport=transport, quantile='1'):.0f}",
+        f"{_delta_mean(before, after, 'signer_relay_send_duration_us', transport):.0f}",
+        f"{_delta_mean(before, after, 'signer_relay_loop_duration_us', transport):.0f}",
+        f"{loop_sum / (seconds * 1e6) * 100:.2f}",
+    ]
+
+    line = " | ".join(value.rjust(width) if i else value.ljust(width) for i, (value, (_, width)) in enumerate(zip(row, COLUMNS)))
+    if not output.exists():
+        header = " | ".join(title.ljust(width) for title, width in COLUMNS)
+        rule = "-|-".join("-" * width for _, width in COLUMNS)
+        output.parent.mkdir(parents=True, exist_ok=True)
+        output.write_text(header + "\n" + rule + "\n")
+    with output.open("a") as handle:
+        handle.write(line + "\n")
+    print(line)
+    print(f"Appended to {output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""
+CA bundle for relay chain validation
+Converts a PEM file of root certificates into data/cert/x509_crt_bundle.bin
+in the ESP-IDF certificate bundle format, which WiFiClientSecure loads
+through setCACertBundle() (see beginSslWithBundle() in src/relay_link.cpp).
+The bundle is linked into the app with board_build.embed_files.
+
+Usage:
+  python3 gen_ca_bundle.py [cacert.pem]
+
+Defaults to the system bundle. Mozilla's list is at
+https://curl.se/ca/cacert.pem; regenerate when it changes.
+
+Layout (big endian):
+  header   uint16 certificate count
+  entries  count x { uint16 subject length, uint16 key length,
+                     subject DER, SubjectPublicKeyInfo DER }
+Entries are sorted by subject DER so the firmware can binary search them
+by issuer name.
+"""
+
+import base64
+import re
+import struct
+import sys
+from pathlib import Path
+
+DEFAULT_INPUT = "/etc/ssl/certs/ca-certificates.crt"
+OUTPUT = Path(__file__).resolve().parent / "data" / "cert" / "x509_crt_bundle.bin"
+
+
+def _read_element(der, offset):
+    """Returns (tag, start of content, end of element) for the DER element at offset"""
+    tag = der[offset]
+    length = der[offset + 1]
+    start = offset + 2
+    if length & 0x80:
+        count = length & 0x7F
+        length = int.from_bytes(der[start:start + count], "big")
+        start += count
+    return tag, start, start + length
+
+
+def _subject_and_key(der):
+    """Subject Name and SubjectPublicKeyInfo of a certificate, both as DER"""
+    _, cert_start, _ = _read_element(der, 0)
+    _, tbs_start, _ = _read_element(der, cert_start)
+
+    fields = []
+    offset = tbs_start
+    while len(fields) < 7:
+        tag, _, end = _read_element(der, offset)
+        fields.append((tag, offset, end))
+        offset = end
+
+    # Optional [0] version, then serial, signature, issuer, validity, subject, key
+    if fields[0][0] == 0xA0:
+        fields = fields[1:]
+    _, subject_start, subject_end = fields[4]
+    _, key_start, key_end = fields[5]
+    return der[subject_start:subject_end], der[key_start:key_end]
+
+
+def main():
+    source = Path(sys.argv[1] if len(sys.argv) > 1 else DEFAULT_INPUT)
+    pem = source.read_text()
+    blocks = re.findall(r"-----BEGIN CERTIFICATE-----(.*?)-----END CERTIFICATE-----", pem, re.S)
+
+    entries = {}
+    for block in blocks:
+        subject, key = _subject_and_key(base64.b64decode("".join(block.split())))
+        entries[subject] = key
+
+    bundle = struct.pack(">H", len(entries))
+    for subject in sorted(entries):
+        key = entries[subject]
+        bundle += struct.pack(">HH", len(subject), len(key)) + subject + key
+
+    OUTPUT.parent.mkdir(parents=True, exist_ok=True)
+    OUTPUT.write_bytes(bundle)
+    print(f"Wrote {len(entries)} CA certificates from {source} to {OUTPUT} ({len(bundle)} bytes)")
+
+
+if __name__ == "__main__":
+    main()
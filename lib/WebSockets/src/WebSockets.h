@@ -42,6 +42,17 @@
 
 #include "WebSocketsVersion.h"
 
+// spans for the firmware's event trace, when the tracing library is present
+#if defined(ESP32) && defined(__has_include)
+#if __has_include(<signer_trace.h>)
+#include <signer_trace.h>
+#define WEBSOCKETS_TRACE_SCOPE(name) TRACE_SCOPE(name)
+#endif
+#endif
+#ifndef WEBSOCKETS_TRACE_SCOPE
+#define WEBSOCKETS_TRACE_SCOPE(name)
+#endif
+
 #ifndef NODEBUG_WEBSOCKETS
 #ifdef DEBUG_ESP_PORT
 #define DEBUG_WEBSOCKETS(...)               \
@@ -63,7 +74,9 @@
 
 #if defined(ESP8266) || defined(ESP32)
 
-#define WEBSOCKETS_MAX_DATA_SIZE (250 * 1024) // This is the only line changed
+// Changed from upstream: frames over RemoteSigner::Config::MAX_FRAME_SIZE are refused
+// before the payload buffer is allocated (a static_assert in remote_signer.cpp keeps them equal)
+#define WEBSOCKETS_MAX_DATA_SIZE (96 * 1024)
 #define WEBSOCKETS_USE_BIG_MEM
 #define GET_FREE_HEAP ESP.getFreeHeap()
 // moves all Header strings to Flash (~300 Byte)
@@ -33,6 +33,10 @@ WebSocketsClient::WebSocketsClient() {
     _reconnectInterval   = 500;
     _port                = 0;
     _host                = "";
+#if defined(ESP32)
+    _useConnectAddress = false;
+    _connectStarted    = 0;
+#endif
 }
 
 WebSocketsClient::~WebSocketsClient() {
@@ -313,7 +317,31 @@ void WebSocketsClient::loop(void) {
         }
         WEBSOCKETS_YIELD();
 #if defined(ESP32)
-        if(_client.tcp->connect(_host.c_str(), _port, WEBSOCKETS_TCP_TIMEOUT)) {
+        WEBSOCKETS_TRACE_SCOPE("ws_connect");
+        _connectStarted = millis();
+        bool tcpConnected;
+        if(_useConnectAddress) {
+#if defined(HAS_SSL)
+            if(_client.isSSL) {
+                // pre-resolved address, the hostname is still used for SNI
+                tcpConnected = _client.ssl->connect(_connectAddress, _port, _host.c_str(), _CA_cert, NULL, NULL);
+            } else
+#endif
+            {
+                tcpConnected = _client.tcp->connect(_connectAddress, _port, WEBSOCKETS_TCP_TIMEOUT);
+            }
+        } else {
+            tcpConnected = _client.tcp->connect(_host.c_str(), _port, WEBSOCKETS_TCP_TIMEOUT);
+        }
+#if defined(HAS_SSL)
+        // checked after the TLS handshake, before the upgrade request is sent
+        if(tcpConnected && _client.isSSL && _peerCertVerifier && !_peerCertVerifier(_client.ssl->getPeerCertificate())) {
+            DEBUG_WEBSOCKETS("[WS-Client] peer certificate rejected\n");
+            _client.ssl->stop();
+            tcpConnected = false;
+        }
+#endif
+        if(tcpConnected) {
 #else
         if(_client.tcp->connect(_host.c_str(), _port)) {
 #endif
@@ -474,6 +502,45 @@ void WebSocketsClient::setReconnectInterval(unsigned long time) {
     _reconnectInterval = time;
 }
 
+#if defined(ESP32)
+/**
+ * connect to this address instead of resolving _host
+ * the hostname is still sent in the Host header and used for SNI
+ * @param address IPAddress
+ */
+void WebSocketsClient::setConnectAddress(IPAddress address) {
+    _connectAddress    = address;
+    _useConnectAddress = true;
+}
+
+/**
+ * go back to resolving _host on every connect
+ */
+void WebSocketsClient::clearConnectAddress(void) {
+    _useConnectAddress = false;
+}
+
+/**
+ * millis() when the latest connect attempt began, after any address lookup
+ * made by the caller (lookups by the library itself are included)
+ * @return unsigned long
+ */
+unsigned long WebSocketsClient::getConnectStarted(void) {
+    return _connectStarted;
+}
+#endif
+
+#if defined(ESP32) && defined(HAS_SSL)
+/**
+ * called with the server certificate after every TLS handshake
+ * returning false drops the connection before any data is sent
+ * @param verifier PeerCertVerifier, NULL to disable
+ */
+void WebSocketsClient::setPeerCertVerifier(PeerCertVerifier verifier) {
+    _peerCertVerifier = verifier;
+}
+#endif
+
 bool WebSocketsClient::isConnected(void) {
     return (_client.status == WSC_CONNECTED);
 }
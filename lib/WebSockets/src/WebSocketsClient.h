@@ -27,6 +27,10 @@
 
 #include "WebSockets.h"
 
+#if defined(ESP32) && defined(HAS_SSL)
+#include <mbedtls/x509_crt.h>
+#endif
+
 class WebSocketsClient : protected WebSockets {
   public:
 #ifdef __AVR__
@@ -108,6 +112,17 @@ class WebSocketsClient : protected WebSockets {
 
     void setReconnectInterval(unsigned long time);
 
+#if defined(ESP32)
+    void setConnectAddress(IPAddress address);
+    void clearConnectAddress(void);
+    unsigned long getConnectStarted(void);
+#endif
+
+#if defined(ESP32) && defined(HAS_SSL)
+    typedef std::function<bool(const mbedtls_x509_crt * peerCert)> PeerCertVerifier;
+    void setPeerCertVerifier(PeerCertVerifier verifier);
+#endif
+
     void enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
     void disableHeartbeat();
 
@@ -117,6 +132,16 @@ class WebSocketsClient : protected WebSockets {
     String _host;
     uint16_t _port;
 
+#if defined(ESP32)
+    IPAddress _connectAddress;
+    bool _useConnectAddress;
+    unsigned long _connectStarted;
+#endif
+
+#if defined(ESP32) && defined(HAS_SSL)
+    PeerCertVerifier _peerCertVerifier;
+#endif
+
 #if defined(HAS_SSL)
 #ifdef SSL_AXTLS
     String _fingerprint;
@@ -0,0 +1,65 @@
+#ifndef NOSTR_ENVELOPE_H
+#define NOSTR_ENVELOPE_H
+
+#include "nostr.h"
+#include "nip44/nip44.h"
+
+namespace nostr
+{
+    /**
+     * @brief Encryption scheme policies for encrypted DM envelopes
+     *
+     * Each policy exposes the same static interface (detect, decrypt, encrypt)
+     * so the envelope pipeline can be instantiated per scheme at compile time
+     * instead of comparing scheme names at run time.
+     */
+    struct Nip04Scheme
+    {
+        static bool detect(const String &content)
+        {
+            return content.indexOf("?iv=") != -1;
+        }
+
+        static String decrypt(const char *privateKeyHex, const String &senderPubKeyHex, String &content)
+        {
+            return decryptNip04Ciphertext(content, privateKeyHex, senderPubKeyHex);
+        }
+
+        static String encrypt(const char *privateKeyHex, const char *recipientPubKeyHex, String &content)
+        {
+            return getCipherText(privateKeyHex, recipientPubKeyHex, content);
+        }
+    };
+
+    struct Nip44Scheme
+    {
+        static bool detect(const String &content)
+        {
+            return !Nip04Scheme::detect(content);
+        }
+
+        static String decrypt(const char *privateKeyHex, const String &senderPubKeyHex, String &content)
+        {
+            return executeDecryptMessageNip44(content, privateKeyHex, senderPubKeyHex);
+        }
+
+        static String encrypt(const char *privateKeyHex, const char *recipientPubKeyHex, String &content)
+        {
+            return executeEncryptMessageNip44(content, privateKeyHex, recipientPubKeyHex);
+        }
+    };
+
+    /**
+     * @brief Encrypt content with the given scheme and wrap it in a signed event
+     *
+     * @param replyToEventId Request being answered, tagged as ["e", id] when set
+     * @return String serialised ["EVENT", {...}] message ready to send
+     */
+    template <typename Scheme>
+    String getEncryptedDm(char const *privateKeyHex, char const *pubKeyHex, char const *recipientPubKeyHex, uint16_t kind, unsigned long timestamp, String content, const String &replyToEventId = "")
+    {
+        String encryptedContent = Scheme::encrypt(privateKeyHex, recipientPubKeyHex, content);
+        return signEncryptedDm(privateKeyHex, pubKeyHex, recipientPubKeyHex, kind, timestamp, encryptedContent, replyToEventId);
+    }
+}
+#endif
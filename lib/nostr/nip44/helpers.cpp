@@ -8,6 +8,7 @@
 #include <mbedtls/base64.h>
 #include <mbedtls/md.h>
 #include <mbedtls/chacha20.h>
+#include <signer_trace.h>
 
 void logInfo(const String msg) {
     // Serial.println("/log " + msg);
@@ -37,6 +38,7 @@ String getTokenAtPosition(String str, String separator, int position) {
 }
 
 String generateSharedSecret(String privateKeyHex, String publicKeyHex) {
+  TRACE_SCOPE("nip44_shared_secret");
   // Reconstruct full public key if only X-coordinate is provided
   if (publicKeyHex.length() == 64) {
     publicKeyHex = reconstructPublicKey(publicKeyHex);
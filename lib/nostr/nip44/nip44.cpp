@@ -6,6 +6,7 @@
 #include <bootloader_random.h>
 #include <mbedtls/base64.h>
 #include <mbedtls/md.h>
+#include <signer_trace.h>
 #include <vector>
 
 // NIP-44 encryption/decryption implementation
@@ -286,6 +287,7 @@ String base64_encode(const uint8_t* input, size_t length) {
 
 // Update the encryption function with ChaCha20 and proper MAC
 String encryptMessageNip44(const String &plaintext, const String &sharedSecretHex) {
+    TRACE_SCOPE("nip44_encrypt");
     try {
         // Convert shared secret from hex
         uint8_t conversation_key[32];
@@ -341,9 +343,20 @@ String encryptMessageNip44(const String &plaintext, const String &sharedSecretHe
 
 // Update decryption function with ChaCha20 and proper MAC verification
 String decryptMessageNip44(const String &payload, const String &sharedSecretHex) {
+    TRACE_SCOPE("nip44_decrypt");
     try {
         logInfo("Decrypting payload of length: " + String(payload.length()));
         
+        // Bound the work before any allocation or decoding
+        if (payload.length() < NIP44_MIN_PAYLOAD_LENGTH || payload.length() > NIP44_MAX_PAYLOAD_LENGTH) {
+            logInfo("Decrypt failed: Invalid payload length");
+            return "";
+        }
+        if (payload[0] == '#') {
+            logInfo("Decrypt failed: Unsupported encryption version");
+            return "";
+        }
+        
         // First get the required buffer size
         size_t binary_len = 0;
         int ret = mbedtls_base64_decode(nullptr, 0, &binary_len,
@@ -498,7 +511,7 @@ String executeEncryptMessageNip44(String data, String privateKeyHex, String thir
 String executeDecryptMessageNip44(String data, String privateKeyHex, String thirdPartyPublicKeyHex) {
     logInfo("Full command data length: " + String(data.length()));
     
-    if (data == "") "";
+    if (data == "") return "";
     
     // Get the shared secret as the 3rd party public key
     logInfo("Public key length: " + String(thirdPartyPublicKeyHex.length()));
@@ -6,6 +6,10 @@
 // NIP-44 constant salt
 extern const uint8_t NIP44_SALT[8];
 
+// Valid base64 payload lengths per the NIP-44 v2 spec (32-byte to 65535-byte padded plaintext)
+const size_t NIP44_MIN_PAYLOAD_LENGTH = 132;
+const size_t NIP44_MAX_PAYLOAD_LENGTH = 87472;
+
 // Helper functions
 uint32_t _math_int_log2(uint32_t x);
 size_t calcPaddedLen(size_t unpadded_len);
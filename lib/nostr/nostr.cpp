@@ -1,5 +1,7 @@
 #include "nostr.h"
+#include "envelope.h"
 #include "nip44/nip44.h"
+#include <signer_trace.h>
 
 namespace nostr
 {
@@ -157,6 +159,7 @@ namespace nostr
 
     DynamicJsonDocument nostrEventDoc(0);
     byte *encryptedMessageBin;
+    size_t encryptedMessageBinCapacity = 0;
 
     unsigned long timer = 0;
     void _startTimer(const char *timedEvent)
@@ -185,6 +188,7 @@ namespace nostr
     {
         nostrEventDoc = DynamicJsonDocument(nostrEventDocCapacity);
         encryptedMessageBin = (byte *)malloc(encryptedMessageBinSize);
+        encryptedMessageBinCapacity = encryptedMessageBin ? encryptedMessageBinSize : 0;
     }
 
     void _logToSerialWithTitle(String title, String message)
@@ -237,17 +241,35 @@ namespace nostr
 
     String decryptNip04Ciphertext(String &cipherText, String privateKeyHex, String senderPubKeyHex)
     {
+        TRACE_SCOPE("nip04_decrypt");
         _startTimer("decryptNip04Ciphertext");
-        String encryptedMessage = cipherText.substring(0, cipherText.indexOf("?iv="));
-        _logOkWithHeapSize("Got encryptedMessage");
+        int ivIndex = cipherText.indexOf("?iv=");
+        if (ivIndex == -1)
+        {
+            Serial.println("IV not found in content");
+            return "";
+        }
+
+        // Reject oversized input before decoding into the shared buffer
+        String iv = cipherText.substring(ivIndex + 4);
+        if (iv.length() != NIP04_IV_BASE64_LENGTH)
+        {
+            Serial.println("Invalid NIP-04 IV length: " + String(iv.length()));
+            return "";
+        }
+
+        String encryptedMessage = cipherText.substring(0, ivIndex);
         int encryptedMessageSize = (encryptedMessage.length() * 3) / 4;
+        if (encryptedMessageSize == 0 || (size_t)encryptedMessageSize > encryptedMessageBinCapacity)
+        {
+            Serial.println("Invalid NIP-04 ciphertext length: " + String(encryptedMessage.length()));
+            return "";
+        }
+        _logOkWithHeapSize("Got encryptedMessage");
         fromBase64(encryptedMessage, encryptedMessageBin, encryptedMessageSize); // Assuming fromBase64 modifies encryptedMessageSize to actual decoded size
 
-        String iv = cipherText.substring(cipherText.indexOf("?iv=") + 4);
-        // calculate the ivSize for ivBin based on the iv size
-        int ivSize = (iv.length() * 3) / 4;
-        byte ivBin[ivSize];
-        fromBase64(iv, ivBin, ivSize);
+        byte ivBin[16];
+        fromBase64(iv, ivBin, sizeof(ivBin));
         _logToSerialWithTitle("iv", iv);
         _stopTimer("decryptNip04Ciphertext: Got ivBin");
 
@@ -311,7 +333,7 @@ namespace nostr
 
     String getContent(const String &serialisedJson)
     {
-        DeserializationError error = deserializeJson(nostrEventDoc, serialisedJson);
+        DeserializationError error = deserializeJson(nostrEventDoc, serialisedJson, DeserializationOption::NestingLimit(JSON_NESTING_LIMIT));
         if (error)
         {
             Serial.print(F("deserializeJson() failed: "));
@@ -322,7 +344,7 @@ namespace nostr
 
     String getSenderPubKeyHex(const String &serialisedJson)
     {
-        DeserializationError error = deserializeJson(nostrEventDoc, serialisedJson);
+        DeserializationError error = deserializeJson(nostrEventDoc, serialisedJson, DeserializationOption::NestingLimit(JSON_NESTING_LIMIT));
         if (error)
         {
             Serial.print(F("deserializeJson() failed: "));
@@ -331,9 +353,20 @@ namespace nostr
         return nostrEventDoc[2]["pubkey"];
     }
 
+    String getEventId(const String &serialisedJson)
+    {
+        DeserializationError error = deserializeJson(nostrEventDoc, serialisedJson, DeserializationOption::NestingLimit(JSON_NESTING_LIMIT));
+        if (error)
+        {
+            Serial.print(F("deserializeJson() failed: "));
+            Serial.println(error.c_str());
+        }
+        return nostrEventDoc[2]["id"];
+    }
+
     std::pair<String, String> getPubKeyAndContent(const String &serialisedJson)
     {
-        DeserializationError error = deserializeJson(nostrEventDoc, serialisedJson);
+        DeserializationError error = deserializeJson(nostrEventDoc, serialisedJson, DeserializationOption::NestingLimit(JSON_NESTING_LIMIT));
         if (error)
         {
             Serial.print(F("deserializeJson() failed: "));
@@ -357,29 +390,13 @@ namespace nostr
         String content = result.second;
         _stopTimer("nip04Decrypt: Got result from getPubKeyAndContent");
 
-        int ivIndex = content.indexOf("?iv=");
-        if (ivIndex == -1)
+        // decryptNip04Ciphertext validates and decodes the ciphertext and IV
+        if (content.indexOf("?iv=") == -1)
         {
             Serial.println("IV not found in content");
             return "";
         }
 
-        // Extracting encryptedMessage directly from content without using String for the intermediate steps
-        int encryptedMessageLength = ivIndex; // Length of the encrypted message part
-        const char *encryptedMessage = content.c_str(); // Use the content directly
-        if (!encryptedMessage)
-        {
-            Serial.println("Failed to allocate PSRAM for encryptedMessage");
-            return "";
-        }
-
-        int encryptedMessageSize = encryptedMessageLength / 4 * 3; // Base64 encoded size is 4/3 of the binary size
-
-        fromBase64(encryptedMessage, encryptedMessageBin, encryptedMessageSize);
-        _stopTimer("nip04Decrypt: Got encryptedMessageBin");
-
-        _logToSerialWithTitle("encryptedMessage", encryptedMessage);
-
         PrivateKey* cachedPrivateKey = getCachedPrivateKey(String(privateKeyHex));
         PrivateKey privateKey;
         
@@ -453,6 +470,7 @@ namespace nostr
      */
     String getNote(char const *privateKeyHex, char const *pubKeyHex, unsigned long timestamp, String &content, uint16_t kind, String tags)
     {
+        TRACE_SCOPE("nostr_sign_note");
         _startTimer("getNote");
         // convert
         // log timestamp
@@ -529,6 +547,61 @@ namespace nostr
         return serialisedDataString;
     }
 
+    /**
+     * @brief Verify the id and signature of a received event
+     *
+     * The id is recomputed from the NIP-01 commitment
+     * [0,pubkey,created_at,kind,tags,content]; ArduinoJson escapes content
+     * the same way getNote() does.
+     *
+     * @param event
+     * @return true if the id matches and the signature is valid for pubkey
+     */
+    bool verifyEvent(JsonObjectConst event)
+    {
+        TRACE_SCOPE("nostr_verify_event");
+        const char *id = event["id"];
+        const char *pubkey = event["pubkey"];
+        const char *sig = event["sig"];
+        if (id == nullptr || pubkey == nullptr || sig == nullptr ||
+            strlen(id) != 64 || strlen(pubkey) != 64 || strlen(sig) != 128 ||
+            !event["created_at"].is<unsigned long>() || !event["kind"].is<uint16_t>())
+        {
+            return false;
+        }
+
+        DynamicJsonDocument commitment(event.memoryUsage() + JSON_ARRAY_SIZE(6) + 64);
+        commitment.add(0);
+        commitment.add(pubkey);
+        commitment.add(event["created_at"].as<unsigned long>());
+        commitment.add(event["kind"].as<uint16_t>());
+        commitment.add(event["tags"]);
+        commitment.add(event["content"]);
+        if (commitment.overflowed())
+        {
+            return false;
+        }
+        String message;
+        serializeJson(commitment, message);
+
+        byte hash[32] = {0};
+        sha256(message, hash);
+        if (!toHex(hash, 32).equalsIgnoreCase(id))
+        {
+            return false;
+        }
+
+        byte sigBytes[64];
+        if (fromHex(sig, sigBytes, 64) != 64)
+        {
+            return false;
+        }
+        SchnorrSignature signature(sigBytes, sigBytes + 32);
+        // BIP-340 keys are x-only; the even-y point is the one that verifies
+        PublicKey pub(("02" + String(pubkey)).c_str());
+        return pub.schnorr_verify(signature, hash);
+    }
+
     /**
      * @brief Convert a string to a byte array
      *
@@ -582,7 +655,9 @@ namespace nostr
 
         AES_CBC_encrypt_buffer(&ctx, messageBin, byteSize);
 
-        return toHex(messageBin, byteSize);
+        String encryptedHex = toHex(messageBin, byteSize);
+        free(messageBin);
+        return encryptedHex;
     }
 
     /**
@@ -595,6 +670,7 @@ namespace nostr
      */
     String getCipherText(const char *privateKeyHex, const char *recipientPubKeyHex, String &content)
     {
+        TRACE_SCOPE("nip04_encrypt");
         _startTimer("getCipherText");
         // Get shared point
         // Create the private key object
@@ -662,17 +738,6 @@ namespace nostr
         String encryptedMessageHex = encryptData(sharedPointX, iv, content);
         _stopTimer("getCipherText: get encryptedMessageHex");
 
-        // divide the length of the hex string 2 to get the size of the byte array, since each byte consists of 2 hexadecimal characters.
-        int encryptedMessageSize = encryptedMessageHex.length() / 2;
-        // Allocate memory for the encrypted message array
-        uint8_t *encryptedMessage = (uint8_t *)malloc(encryptedMessageSize);
-        if (encryptedMessage == nullptr)
-        {
-            Serial.println("Failed to allocate PSRAM for encryptedMessage");
-        }
-        fromHex(encryptedMessageHex, encryptedMessage, encryptedMessageSize);
-        _stopTimer("getCipherText: get encryptedMessage fromHex");
-
         String encryptedMessageBase64 = hexToBase64(encryptedMessageHex);
         _stopTimer("getCipherText: get encryptedMessageBase64");
 
@@ -692,19 +757,29 @@ namespace nostr
      * @param schnorrSig
      * @return String
      */
-    String getSerialisedEncryptedDmObject(const char *pubKeyHex, const char *recipientPubKeyHex, uint16_t kind, String &msgHash, int timestamp, String &encryptedMessageWithIv, String &schnorrSig)
+    static String getEncryptedDmTags(const char *recipientPubKeyHex, const String &replyToEventId)
+    {
+        String tags = "[[\"p\",\"" + String(recipientPubKeyHex) + "\"]";
+        if (replyToEventId.length() > 0)
+        {
+            tags += ",[\"e\",\"" + replyToEventId + "\"]";
+        }
+        return tags + "]";
+    }
+
+    String getSerialisedEncryptedDmObject(const char *pubKeyHex, const char *recipientPubKeyHex, uint16_t kind, String &msgHash, int timestamp, String &encryptedMessageWithIv, String &schnorrSig, const String &replyToEventId)
     {
         // parse a JSON array
-        String serialisedTagsArray = "[[\"p\",\"" + String(recipientPubKeyHex) + "\"]]";
+        String serialisedTagsArray = getEncryptedDmTags(recipientPubKeyHex, replyToEventId);
         // _logToSerialWithTitle("serialisedTagsArray is: ", serialisedTagsArray);
 
         // create the serialised fullEvent string using sprintf instead of the Arduino JSON library
         return "[\"EVENT\",{\"id\":\"" + msgHash + "\",\"pubkey\":\"" + pubKeyHex + "\",\"created_at\":" + String(timestamp) + ",\"kind\":" + String(kind) + ",\"tags\":" + serialisedTagsArray + ",\"content\":\"" + encryptedMessageWithIv + "\",\"sig\":\"" + schnorrSig + "\"}]";
     }
 
-    String getSerialisedEncryptedDmArray(char const *pubKeyHex, char const *recipientPubKeyHex, uint16_t kind, int timestamp, String &encryptedMessageWithIv)
+    String getSerialisedEncryptedDmArray(char const *pubKeyHex, char const *recipientPubKeyHex, uint16_t kind, int timestamp, String &encryptedMessageWithIv, const String &replyToEventId)
     {
-        String serialisedTagsArray = "[[\"p\",\"" + String(recipientPubKeyHex) + "\"]]";
+        String serialisedTagsArray = getEncryptedDmTags(recipientPubKeyHex, replyToEventId);
         String message = "[0,\"" + String(pubKeyHex) + "\"," + String(timestamp) + "," + String(kind) + "," + serialisedTagsArray + ",\"" + encryptedMessageWithIv + "\"]";
 
         // _logToSerialWithTitle("message is: ", message);
@@ -726,19 +801,29 @@ namespace nostr
      */
     String getEncryptedDm(char const *privateKeyHex, char const *pubKeyHex, char const *recipientPubKeyHex, uint16_t kind, unsigned long timestamp, String content, String type)
     {
-        String encryptedMessageBase64 = "";
         if (type == "nip44") {
-            _startTimer("getEncrypted NIP44 Dm");
-            encryptedMessageBase64 = executeEncryptMessageNip44(content, privateKeyHex, recipientPubKeyHex);
-            _logToSerialWithTitle("NIP44 encrypted message is: ", encryptedMessageBase64);
-            _stopTimer("executeEncryptMessageNip44");
-        } else {
-            _startTimer("getEncrypted NIP44 Dm");
-            encryptedMessageBase64 = getCipherText(privateKeyHex, recipientPubKeyHex, content);
-            _stopTimer("getCipherText");
+            return getEncryptedDm<Nip44Scheme>(privateKeyHex, pubKeyHex, recipientPubKeyHex, kind, timestamp, content);
         }
+        return getEncryptedDm<Nip04Scheme>(privateKeyHex, pubKeyHex, recipientPubKeyHex, kind, timestamp, content);
+    }
 
-        String message = nostr::getSerialisedEncryptedDmArray(pubKeyHex, recipientPubKeyHex, kind, timestamp, encryptedMessageBase64);
+    /**
+     * @brief Wrap already encrypted content in a signed event
+     *
+     * @param privateKeyHex
+     * @param pubKeyHex
+     * @param recipientPubKeyHex
+     * @param kind
+     * @param timestamp
+     * @param encryptedContent
+     * @param replyToEventId
+     * @return String
+     */
+    String signEncryptedDm(char const *privateKeyHex, char const *pubKeyHex, char const *recipientPubKeyHex, uint16_t kind, unsigned long timestamp, String &encryptedContent, const String &replyToEventId)
+    {
+        TRACE_SCOPE("nostr_sign_dm");
+        _startTimer("signEncryptedDm");
+        String message = nostr::getSerialisedEncryptedDmArray(pubKeyHex, recipientPubKeyHex, kind, timestamp, encryptedContent, replyToEventId);
         _stopTimer("get serialised encrypted dm array");
 
         byte hash[64] = {0}; // hash
@@ -772,7 +857,7 @@ namespace nostr
         String signatureHex = String(signature);
         _logToSerialWithTitle("Schnorr sig is: ", signatureHex);
 
-        String serialisedEventData = nostr::getSerialisedEncryptedDmObject(pubKeyHex, recipientPubKeyHex, kind, msgHash, timestamp, encryptedMessageBase64, signatureHex);
+        String serialisedEventData = nostr::getSerialisedEncryptedDmObject(pubKeyHex, recipientPubKeyHex, kind, msgHash, timestamp, encryptedContent, signatureHex, replyToEventId);
         _stopTimer("get serialised encrypted dm object");
         // _logToSerialWithTitle("serialisedEventData is", serialisedEventData);
         return serialisedEventData;
@@ -11,6 +11,10 @@
 
 namespace nostr
 {
+    // Bounds applied to untrusted relay input
+    const uint8_t JSON_NESTING_LIMIT = 6;       // ["EVENT", sub, {"tags": [[...]]}] plus slack
+    const size_t NIP04_IV_BASE64_LENGTH = 24;   // 16-byte AES-CBC IV
+
     void initMemorySpace(size_t nostrEventDocCapacity, size_t encryptedMessageBinSize);
 
     void _logToSerialWithTitle(String title, String message);
@@ -21,6 +25,8 @@ namespace nostr
 
     String getSenderPubKeyHex(const String &serialisedJson);
 
+    String getEventId(const String &serialisedJson);
+
     std::pair<String, String> getPubKeyAndContent(const String &serialisedJson);
 
     String nip04Decrypt(const char *privateKeyHex, String serialisedJson);
@@ -35,14 +41,21 @@ namespace nostr
 
     String getNote(char const *privateKeyHex, char const *pubKeyHex, unsigned long timestamp, String &content, uint16_t kind, String tags = "[]");
 
+    // Recomputes the NIP-01 id and checks the BIP-340 signature against the event's pubkey
+    bool verifyEvent(JsonObjectConst event);
+
     String encryptData(byte key[32], byte iv[16], String &msg);
 
     String getCipherText(const char *privateKeyHex, const char *recipientPubKeyHex, String &content);
 
-    String getSerialisedEncryptedDmObject(const char *pubKeyHex, const char *recipientPubKeyHex, uint16_t kind, String &msgHash, int timestamp, String &encryptedMessageWithIv, String &schnorrSig);
+    // replyToEventId, when set, adds an ["e", id] tag naming the request being answered
+    String getSerialisedEncryptedDmObject(const char *pubKeyHex, const char *recipientPubKeyHex, uint16_t kind, String &msgHash, int timestamp, String &encryptedMessageWithIv, String &schnorrSig, const String &replyToEventId = "");
+
+    String getSerialisedEncryptedDmArray(char const *pubKeyHex, char const *recipientPubKeyHex, uint16_t kind, int timestamp, String &encryptedMessageWithIv, const String &replyToEventId = "");
 
-    String getSerialisedEncryptedDmArray(char const *pubKeyHex, char const *recipientPubKeyHex, uint16_t kind, int timestamp, String &encryptedMessageWithIv);
+    String signEncryptedDm(char const *privateKeyHex, char const *pubKeyHex, char const *recipientPubKeyHex, uint16_t kind, unsigned long timestamp, String &encryptedContent, const String &replyToEventId = "");
 
+    // Prefer the scheme-templated getEncryptedDm in envelope.h
     String getEncryptedDm(char const *privateKeyHex, char const *pubKeyHex, char const *recipientPubKeyHex, uint16_t kind, unsigned long timestamp, String content, String type);
 
 
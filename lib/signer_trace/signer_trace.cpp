@@ -0,0 +1,246 @@
+#include "signer_trace.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace Trace {
+    struct Event {
+        int64_t timestamp_us;
+        const char* name;
+        TaskHandle_t task;
+        uint32_t sequence;  // Write index + 1; 0 while the slot is being filled
+        char phase;         // 'B', 'E' or 'i'
+        uint8_t core;
+    };
+
+    static Event* ring = nullptr;
+    static uint32_t ring_mask = 0;
+    static uint32_t write_index = 0;
+    static volatile bool recording = false;
+
+    bool init(size_t events) {
+        if (ring != nullptr) {
+            return true;
+        }
+
+        // Power-of-two capacity so a slot is the write index masked
+        size_t capacity = 1;
+        while (capacity * 2 <= events) {
+            capacity *= 2;
+        }
+
+        ring = (Event*)heap_caps_calloc(capacity, sizeof(Event), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (ring == nullptr) {
+            Serial.println("Trace::init() - No PSRAM for " + String(capacity) + " events, tracing disabled");
+            return false;
+        }
+        ring_mask = capacity - 1;
+        recording = true;
+        Serial.println("Trace::init() - Recording into " + String(capacity) + " events (" + String(capacity * sizeof(Event) / 1024) + " KB PSRAM)");
+        return true;
+    }
+
+    bool isInitialized() {
+        return ring != nullptr;
+    }
+
+    static void record(const char* name, char phase) {
+        if (!recording) {
+            return;
+        }
+
+        uint32_t index = __atomic_fetch_add(&write_index, 1, __ATOMIC_RELAXED);
+        Event& event = ring[index & ring_mask];
+        __atomic_store_n(&event.sequence, 0, __ATOMIC_RELAXED);
+        event.timestamp_us = esp_timer_get_time();
+        event.name = name;
+        event.task = xTaskGetCurrentTaskHandle();
+        event.phase = phase;
+        event.core = xPortGetCoreID();
+        __atomic_store_n(&event.sequence, index + 1, __ATOMIC_RELEASE);
+    }
+
+    void begin(const char* name) {
+        record(name, 'B');
+    }
+
+    void end(const char* name) {
+        record(name, 'E');
+    }
+
+    void instant(const char* name) {
+        record(name, 'i');
+    }
+
+    void setRecording(bool enabled) {
+        recording = enabled && ring != nullptr;
+    }
+
+    bool isRecording() {
+        return recording;
+    }
+
+    void clear() {
+        bool was_recording = recording;
+        recording = false;
+        if (ring != nullptr) {
+            for (uint32_t i = 0; i <= ring_mask; i++) {
+                __atomic_store_n(&ring[i].sequence, 0, __ATOMIC_RELAXED);
+            }
+        }
+        __atomic_store_n(&write_index, 0, __ATOMIC_RELAXED);
+        recording = was_recording;
+    }
+
+    // Export in progress; recording stays paused so the ring is a frozen snapshot
+    struct Export {
+        bool active = false;
+        bool was_recording = false;
+        bool header_written = false;
+        uint32_t first = 0;
+        uint32_t next = 0;
+        uint32_t written = 0;
+        uint32_t exported = 0;
+        TaskHandle_t tasks[Config::MAX_EXPORT_TASKS];
+        int task_count = 0;
+        int next_thread = 0;
+    };
+
+    static Export export_state;
+
+    // Thread ids in the export are small indices; names come from tasks still alive
+    static int taskIndex(TaskHandle_t* tasks, int& count, TaskHandle_t task) {
+        for (int i = 0; i < count; i++) {
+            if (tasks[i] == task) {
+                return i + 1;
+            }
+        }
+        if (count < Config::MAX_EXPORT_TASKS) {
+            tasks[count++] = task;
+            return count;
+        }
+        return 0;
+    }
+
+    // Writes thread names [from, to) of the export's task table
+    static void writeThreadNames(Print& out, int from, int to) {
+        UBaseType_t capacity = uxTaskGetNumberOfTasks() + 4;
+        TaskStatus_t* status = (TaskStatus_t*)malloc(capacity * sizeof(TaskStatus_t));
+        UBaseType_t alive = status != nullptr ? uxTaskGetSystemState(status, capacity, NULL) : 0;
+
+        char line[128];
+        for (int i = from; i < to; i++) {
+            TaskHandle_t task = export_state.tasks[i];
+            const char* name = nullptr;
+            for (UBaseType_t j = 0; j < alive; j++) {
+                if (status[j].xHandle == task) {
+                    name = status[j].pcTaskName;
+                    break;
+                }
+            }
+            if (name != nullptr) {
+                snprintf(line, sizeof(line), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", i + 1, name);
+            } else {
+                snprintf(line, sizeof(line), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"task %p\"}}", i + 1, task);
+            }
+            out.print(line);
+        }
+        free(status);
+    }
+
+    static void writeEvent(Print& out, const Event& event) {
+        char line[160];
+        int tid = taskIndex(export_state.tasks, export_state.task_count, event.task);
+        if (event.phase == 'i') {
+            snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lld,\"pid\":1,\"tid\":%d,\"args\":{\"core\":%u}}",
+                     event.name, (long long)event.timestamp_us, tid, event.core);
+        } else {
+            snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%d,\"args\":{\"core\":%u}}",
+                     event.name, event.phase, (long long)event.timestamp_us, tid, event.core);
+        }
+        out.print(line);
+    }
+
+    bool beginExport() {
+        if (ring == nullptr || export_state.active) {
+            return false;
+        }
+
+        export_state.was_recording = recording;
+        recording = false;
+        // Let writers that already claimed a slot on the other core finish
+        delay(2);
+
+        uint32_t written = __atomic_load_n(&write_index, __ATOMIC_ACQUIRE);
+        uint32_t capacity = ring_mask + 1;
+        export_state.first = written > capacity ? written - capacity : 0;
+        export_state.next = export_state.first;
+        export_state.written = written;
+        export_state.exported = 0;
+        export_state.task_count = 0;
+        export_state.next_thread = 0;
+        export_state.header_written = false;
+        export_state.active = true;
+        return true;
+    }
+
+    bool exportChunk(Print& out, size_t maxLines) {
+        if (!export_state.active) {
+            return false;
+        }
+
+        size_t lines = 0;
+        if (!export_state.header_written) {
+            out.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+            out.print("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"signer\"}}");
+            export_state.header_written = true;
+            lines++;
+        }
+
+        while (lines < maxLines && export_state.next < export_state.written) {
+            uint32_t index = export_state.next++;
+            const Event& event = ring[index & ring_mask];
+            if (__atomic_load_n(&event.sequence, __ATOMIC_ACQUIRE) != index + 1) {
+                continue;  // Torn before the export started
+            }
+            writeEvent(out, event);
+            export_state.exported++;
+            lines++;
+        }
+
+        if (lines < maxLines && export_state.next_thread < export_state.task_count) {
+            size_t pending = export_state.task_count - export_state.next_thread;
+            int to = export_state.next_thread + (int)min(pending, maxLines - lines);
+            writeThreadNames(out, export_state.next_thread, to);
+            lines += to - export_state.next_thread;
+            export_state.next_thread = to;
+        }
+
+        if (lines >= maxLines || export_state.next < export_state.written || export_state.next_thread < export_state.task_count) {
+            return true;
+        }
+
+        out.print("\n]}\n");
+        Serial.println("Trace::exportChunk() - Exported " + String(export_state.exported) + " events, " + String(export_state.first) + " overwritten");
+        export_state.active = false;
+        recording = export_state.was_recording;
+        return false;
+    }
+
+    bool isExporting() {
+        return export_state.active;
+    }
+
+    void exportJson(Print& out) {
+        if (!beginExport()) {
+            if (export_state.active) {
+                Serial.println("Trace::exportJson() - Another export is in progress");
+            }
+            out.println("{\"traceEvents\":[]}");
+            return;
+        }
+        while (exportChunk(out, SIZE_MAX)) {
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Flight-recorder tracing of begin/end and instant events.
+ *
+ * Events go into a fixed ring in PSRAM that always holds the most recent
+ * captures; older events are overwritten. Recording claims a slot with one
+ * atomic increment and takes no lock, so it is safe from any task on
+ * either core. Each event carries the calling task, the core it ran on and
+ * a microsecond timestamp.
+ *
+ * exportJson() writes the ring as Chrome trace event JSON, which loads
+ * directly in ui.perfetto.dev or chrome://tracing. Callers that must not
+ * block for the whole ring use beginExport() and then exportChunk() once
+ * per loop pass; recording stays paused until the last chunk is written.
+ *
+ * Event names must be string literals; they are stored by pointer.
+ */
+namespace Trace {
+    bool init(size_t events);
+    bool isInitialized();
+
+    void begin(const char* name);
+    void end(const char* name);
+    void instant(const char* name);
+
+    void setRecording(bool recording);
+    bool isRecording();
+    void clear();
+
+    // Pauses recording while the ring is written out
+    void exportJson(Print& out);
+
+    // Incremental export: false from beginExport() if one is already running,
+    // exportChunk() writes at most maxLines lines and returns false when done
+    bool beginExport();
+    bool exportChunk(Print& out, size_t maxLines);
+    bool isExporting();
+
+    // Ends the span when it goes out of scope
+    class Scope {
+    public:
+        explicit Scope(const char* name) : name(name) { begin(name); }
+        ~Scope() { end(name); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char* name;
+    };
+
+    namespace Config {
+        const size_t DEFAULT_EVENTS = 16384;   // 24 bytes each, in PSRAM
+        const int MAX_EXPORT_TASKS = 32;
+    }
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+PlatformIO Extra Script for the read-only asset partition
+Packs everything under assets/ into assets.bin for the "assets" data
+partition, which the firmware maps with esp_partition_mmap (see
+src/asset_store.h). The pack is rebuilt before every build and flashed
+after every upload.
+
+Layout (little endian):
+  header   magic "SGNA", uint32 version, uint32 entry count, uint32 reserved
+  entries  count x { char name[48], uint32 offset, uint32 size }
+  data     each asset at a 16-byte aligned offset from the pack start
+"""
+
+import csv
+import os
+import struct
+from pathlib import Path
+
+Import("env")
+
+MAGIC = b"SGNA"
+VERSION = 1
+NAME_SIZE = 48
+ALIGNMENT = 16
+PARTITION_NAME = "assets"
+
+
+def _align(value):
+    return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1)
+
+
+def _collect(assets_dir):
+    files = []
+    for path in sorted(assets_dir.rglob("*")):
+        if path.is_file():
+            name = path.relative_to(assets_dir).as_posix()
+            if len(name.encode()) >= NAME_SIZE:
+                raise ValueError(f"Asset name too long (max {NAME_SIZE - 1}): {name}")
+            files.append((name, path.read_bytes()))
+    return files
+
+
+def pack_assets(source, target, env):
+    """Build assets.bin from the assets/ directory"""
+    project_dir = Path(env.get("PROJECT_DIR"))
+    assets_dir = project_dir / "assets"
+    output = Path(env.subst("$BUILD_DIR")) / "assets.bin"
+
+    files = _collect(assets_dir) if assets_dir.exists() else []
+    table_size = 16 + len(files) * (NAME_SIZE + 8)
+
+    entries = b""
+    data = b""
+    offset = _align(table_size)
+    for name, content in files:
+        entries += struct.pack(f"<{NAME_SIZE}sII", name.encode(), offset, len(content))
+        padding = _align(len(content)) - len(content)
+        data += content + b"\0" * padding
+        offset += len(content) + padding
+
+    header = struct.pack("<4sIII", MAGIC, VERSION, len(files), 0)
+    table = header + entries
+    table += b"\0" * (_align(table_size) - len(table))
+
+    output.parent.mkdir(parents=True, exist_ok=True)
+    output.write_bytes(table + data)
+    print(f"Packed {len(files)} assets into {output} ({len(table) + len(data)} bytes)")
+    return 0
+
+
+def _partition_offset(env):
+    """Offset of the assets partition from the board's partition table"""
+    table = Path(env.subst("$PARTITIONS_TABLE_CSV"))
+    with table.open() as handle:
+        for row in csv.reader(line for line in handle if not line.lstrip().startswith("#")):
+            if row and row[0].strip() == PARTITION_NAME:
+                return row[3].strip()
+    return None
+
+
+def upload_assets(source, target, env):
+    """Write assets.bin to the assets partition"""
+    offset = _partition_offset(env)
+    if offset is None:
+        print(f"No '{PARTITION_NAME}' partition in the partition table, skipping asset upload")
+        return 0
+
+    image = os.path.join(env.subst("$BUILD_DIR"), "assets.bin")
+    if not os.path.exists(image):
+        pack_assets(source, target, env)
+
+    command = " ".join([
+        '"$PYTHONEXE"', '"$OBJCOPY"',
+        "--chip", env.BoardConfig().get("build.mcu", "esp32s3"),
+    ] + (['--port', '"$UPLOAD_PORT"'] if env.subst("$UPLOAD_PORT") else []) + [
+        "--baud", "$UPLOAD_SPEED",
+        "write_flash", offset, f'"{image}"',
+    ])
+    print(f"Uploading assets to {offset}...")
+    return env.Execute(env.VerboseAction(command, "Writing asset partition"))
+
+
+# Repack on every build so edits under assets/ are always picked up
+env.AddPreAction("buildprog", pack_assets)
+env.AddPostAction("upload", upload_assets)
+
+env.AddCustomTarget(
+    name="packassets",
+    dependencies=None,
+    actions=pack_assets,
+    title="Pack Assets",
+    description="Pack assets/ into the read-only asset partition image"
+)
+
+env.AddCustomTarget(
+    name="uploadassets",
+    dependencies=None,
+    actions=[pack_assets, upload_assets],
+    title="Upload Assets",
+    description="Write the asset partition image without reflashing the app"
+)
@@ -28,6 +28,7 @@ void AXS15231B_Touch::isrTouched() {
     if (instance) {
         instance->touch_int = true;
         instance->isr_count++;
+        instance->isr_micros = micros();
     }
 }
 
@@ -40,6 +41,11 @@ bool AXS15231B_Touch::touched() {
     return update();
 }
 
+uint32_t AXS15231B_Touch::lastInterruptMicros() {
+    // Time of the latest interrupt, for touch latency tracing
+    return isr_micros;
+}
+
 void AXS15231B_Touch::readData(uint16_t *x, uint16_t *y) {
     // Return the latest data points
     *x = point_X;
@@ -20,10 +20,12 @@ public:
     void readData(uint16_t *, uint16_t *);
     void enOffsetCorrection(bool);
     void setOffsets(uint16_t, uint16_t, uint16_t, uint16_t, uint16_t, uint16_t);
+    uint32_t lastInterruptMicros();
 
 protected:
     volatile bool touch_int = false;
     volatile uint32_t isr_count = 0;
+    volatile uint32_t isr_micros = 0;
 
 private:
     bool en_offset_correction = false;
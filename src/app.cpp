@@ -2,6 +2,14 @@
 #include "esp_sleep.h"
 #include "driver/gpio.h"
 #include "driver/rtc_io.h"
+#include "metrics.h"
+#include "load_generator.h"
+#include "system_monitor.h"
+#include <signer_trace.h>
+
+#ifdef SIGNER_HEADLESS
+#include "headless/metrics_server.h"
+#endif
 
 namespace App
 {
@@ -15,6 +23,80 @@ namespace App
     // Activity tracking (for diagnostics only)
     static unsigned long last_activity_time = 0;
 
+    // Serial console commands: "trace" streams the trace ring as Chrome/Perfetto JSON,
+    // "trace clear" empties it
+    static void runSerialCommand(const char *line)
+    {
+        String command = line;
+        command.trim();
+        if (Trace::isExporting() && command.startsWith("trace"))
+        {
+            Serial.println("App::runSerialCommand() - Trace export in progress");
+        }
+        else if (command == "trace")
+        {
+            // Written a few events per loop pass by continueTraceExport()
+            if (!Trace::beginExport())
+            {
+                Serial.println("{\"traceEvents\":[]}");
+            }
+        }
+        else if (command == "trace clear")
+        {
+            Trace::clear();
+            Serial.println("App::runSerialCommand() - Trace ring cleared");
+        }
+    }
+
+    // Writes about what fits in the serial TX buffer, and at least one line so the
+    // export always advances; the loop waits on the UART for one line at most
+    static void continueTraceExport()
+    {
+        if (!Trace::isExporting())
+        {
+            return;
+        }
+        int space = Serial.availableForWrite();
+        size_t lines = space > 0 ? space / Config::TRACE_EXPORT_LINE_BYTES : 0;
+        lines = constrain(lines, (size_t)1, Config::TRACE_EXPORT_LINES_PER_PASS);
+        Trace::exportChunk(Serial, lines);
+    }
+
+    // Console line being typed; filled from whatever bytes are already buffered
+    static char serial_line[Config::SERIAL_COMMAND_MAX + 1];
+    static size_t serial_line_length = 0;
+    static bool serial_line_overflow = false;
+
+    // Never waits for input, so a partial line costs the loop nothing
+    static void processSerialCommands()
+    {
+        while (Serial.available() > 0)
+        {
+            char c = Serial.read();
+            if (c != '\n')
+            {
+                if (serial_line_length < Config::SERIAL_COMMAND_MAX)
+                {
+                    serial_line[serial_line_length++] = c;
+                }
+                else
+                {
+                    serial_line_overflow = true;
+                }
+                continue;
+            }
+
+            serial_line[serial_line_length] = '\0';
+            bool overflow = serial_line_overflow;
+            serial_line_length = 0;
+            serial_line_overflow = false;
+            if (!overflow)
+            {
+                runSerialCommand(serial_line);
+            }
+        }
+    }
+
     void init()
     {
         Serial.println("=== Remote Nostr Signer Initializing ===");
@@ -111,8 +193,23 @@ namespace App
             Serial.println("ERROR: RemoteSigner::processLoop() threw exception");
         }
 
+        // Replay synthetic requests while a diagnostics load test runs
+        LoadGenerator::processLoop();
+
+        // Loop period jitter and per-task CPU / stack sampling
+        SystemMonitor::processLoop();
+
         // Check backlight timeout
         Display::checkBacklightTimeout();
+
+        processSerialCommands();
+        continueTraceExport();
+
+#ifdef SIGNER_HEADLESS
+        // Serve the Prometheus scrape endpoint
+        MetricsServer::processLoop();
+#endif
+
         // Periodic health checks
         if (current_time - last_health_check >= Config::HEALTH_CHECK_INTERVAL)
         {
@@ -179,13 +276,23 @@ namespace App
             if (!RemoteSigner::isConnected())
             {
                 Serial.println("WiFi connected, attempting relay connection...");
+                unsigned long link_lost_time = WiFiManager::getLinkLostTime();
+                if (link_lost_time != 0)
+                {
+                    Metrics::observe("wifi_link_loss_to_relay_reconnect_ms", millis() - link_lost_time);
+                }
                 RemoteSigner::connectToRelay();
             }
         }
         else
         {
             // WiFi disconnected - notify Remote Signer module
-            Serial.println("WiFi disconnected, disconnecting from relay...");
+            Serial.println("WiFi disconnected (reason " + String(WiFiManager::getLastDisconnectReason()) + "), disconnecting from relay...");
+            unsigned long link_lost_time = WiFiManager::getLinkLostTime();
+            if (link_lost_time != 0)
+            {
+                Metrics::observe("wifi_link_loss_to_relay_disconnect_ms", millis() - link_lost_time);
+            }
             RemoteSigner::disconnect();
         }
 
@@ -237,7 +344,7 @@ namespace App
         bool health_ok = true;
 
         // Check WiFi module health
-        if (!WiFiManager::isConnected() && WiFiManager::getStatus() != WL_IDLE_STATUS)
+        if (WiFiManager::getLinkState() == WiFiManager::WIFI_LINK_DOWN)
         {
             Serial.println("WiFi module health check failed");
             health_ok = false;
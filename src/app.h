@@ -82,6 +82,9 @@ namespace App {
         const String BUILD_DATE = __DATE__ " " __TIME__;
         const unsigned long HEALTH_CHECK_INTERVAL = 30000; // 30 seconds
         const unsigned long STATUS_REPORT_INTERVAL = 300000; // 5 minutes
+        const size_t SERIAL_COMMAND_MAX = 64;                 // Longer console lines are discarded
+        const size_t TRACE_EXPORT_LINE_BYTES = 110;           // Typical exported trace event line
+        const size_t TRACE_EXPORT_LINES_PER_PASS = 16;
         
         // Touch handling configuration
         const unsigned long TOUCH_DEBOUNCE_TIME = 50; // 50ms debounce
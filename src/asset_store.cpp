@@ -0,0 +1,126 @@
+#include "asset_store.h"
+#include <esp_partition.h>
+
+namespace AssetStore {
+    struct PackHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    struct PackEntry {
+        char name[Config::NAME_SIZE];
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    static const esp_partition_t* partition = nullptr;
+    static const PackEntry* entries = nullptr;
+    static uint32_t entry_count = 0;
+    static spi_flash_mmap_handle_t table_handle = 0;
+
+    // Filled in on first lookup; mappings are kept for the lifetime of the app
+    static const uint8_t* mapped[Config::MAX_ASSETS] = {};
+    static spi_flash_mmap_handle_t mapped_handles[Config::MAX_ASSETS] = {};
+    static portMUX_TYPE map_lock = portMUX_INITIALIZER_UNLOCKED;
+
+    bool init() {
+        if (entries != nullptr) {
+            return true;
+        }
+
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)Config::PARTITION_SUBTYPE, Config::PARTITION_LABEL);
+        if (partition == nullptr) {
+            Serial.println("AssetStore::init() - No asset partition, web pages unavailable");
+            return false;
+        }
+
+        PackHeader header;
+        if (esp_partition_read(partition, 0, &header, sizeof(header)) != ESP_OK ||
+            memcmp(header.magic, "SGNA", 4) != 0 || header.version != Config::PACK_VERSION) {
+            Serial.println("AssetStore::init() - Asset partition is empty or from another build, run 'pio run -t uploadassets'");
+            partition = nullptr;
+            return false;
+        }
+        if (header.count > (uint32_t)Config::MAX_ASSETS) {
+            Serial.println("AssetStore::init() - Pack has " + String(header.count) + " assets, only " + String(Config::MAX_ASSETS) + " are used");
+            header.count = Config::MAX_ASSETS;
+        }
+
+        const void* table = nullptr;
+        size_t tableSize = sizeof(PackHeader) + header.count * sizeof(PackEntry);
+        esp_err_t err = esp_partition_mmap(partition, 0, tableSize, ESP_PARTITION_MMAP_DATA, &table, &table_handle);
+        if (err != ESP_OK) {
+            Serial.println("AssetStore::init() - Failed to map the asset table: " + String(esp_err_to_name(err)));
+            partition = nullptr;
+            return false;
+        }
+        entries = (const PackEntry*)((const uint8_t*)table + sizeof(PackHeader));
+        entry_count = header.count;
+
+        Serial.println("AssetStore::init() - " + String(entry_count) + " assets in a " + String(partition->size / 1024) + " KB partition at 0x" + String(partition->address, HEX));
+        return true;
+    }
+
+    bool isAvailable() {
+        return entries != nullptr;
+    }
+
+    static int findEntry(const char* name) {
+        for (uint32_t i = 0; i < entry_count; i++) {
+            if (strncmp(entries[i].name, name, Config::NAME_SIZE) == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    bool get(const char* name, Asset& asset) {
+        if (entries == nullptr) {
+            return false;
+        }
+        int index = findEntry(name);
+        if (index < 0) {
+            Serial.println("AssetStore::get() - No asset named " + String(name));
+            return false;
+        }
+
+        const PackEntry& entry = entries[index];
+        if ((size_t)entry.offset + entry.size > partition->size) {
+            Serial.println("AssetStore::get() - Asset " + String(name) + " runs past the partition end");
+            return false;
+        }
+
+        portENTER_CRITICAL(&map_lock);
+        const uint8_t* data = mapped[index];
+        portEXIT_CRITICAL(&map_lock);
+
+        if (data == nullptr && entry.size > 0) {
+            const void* ptr = nullptr;
+            spi_flash_mmap_handle_t handle;
+            esp_err_t err = esp_partition_mmap(partition, entry.offset, entry.size, ESP_PARTITION_MMAP_DATA, &ptr, &handle);
+            if (err != ESP_OK) {
+                Serial.println("AssetStore::get() - Failed to map " + String(name) + ": " + String(esp_err_to_name(err)));
+                return false;
+            }
+
+            // Another task may have mapped it meanwhile; keep the first mapping
+            portENTER_CRITICAL(&map_lock);
+            if (mapped[index] == nullptr) {
+                mapped[index] = (const uint8_t*)ptr;
+                mapped_handles[index] = handle;
+                ptr = nullptr;
+            }
+            data = mapped[index];
+            portEXIT_CRITICAL(&map_lock);
+            if (ptr != nullptr) {
+                spi_flash_munmap(handle);
+            }
+        }
+
+        asset.data = data;
+        asset.size = entry.size;
+        return true;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Read-only assets in the "assets" flash data partition.
+ *
+ * pack_assets.py packs everything under assets/ into the partition at build
+ * time. init() maps only the entry table; each asset is mapped into the data
+ * address space the first time it is looked up and stays mapped. Views point
+ * straight into flash through the cache, so nothing is copied into RAM and a
+ * large table only costs the cache lines actually touched.
+ */
+namespace AssetStore {
+    struct Asset {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+
+        // Zero-copy typed view; count is the number of whole elements
+        template <typename T>
+        const T* as(size_t& count) const {
+            count = size / sizeof(T);
+            return reinterpret_cast<const T*>(data);
+        }
+    };
+
+    bool init();
+    bool isAvailable();
+
+    // Maps the asset on first use; false when the pack or the entry is missing
+    bool get(const char* name, Asset& asset);
+
+    namespace Config {
+        const char* const PARTITION_LABEL = "assets";
+        const uint8_t PARTITION_SUBTYPE = 0x40;     // First custom data subtype
+        const uint32_t PACK_VERSION = 1;            // Matches pack_assets.py
+        const size_t NAME_SIZE = 48;
+        const int MAX_ASSETS = 32;
+    }
+}
@@ -0,0 +1,206 @@
+#include "cert_pins.h"
+#include "metrics.h"
+#include <Preferences.h>
+#include <mbedtls/md.h>
+
+namespace CertPins {
+    static verify_mode_t verify_mode = Config::DEFAULT_MODE;
+
+    // Pins accepted during this boot, one per relay
+    struct SessionPin {
+        String hostPort;
+        uint8_t hash[32];
+        bool valid = false;
+    };
+    static SessionPin session_pins[Config::SESSION_PINS];
+    static int next_session_slot = 0;
+
+    // The relay link and the write relay pool verify from their own tasks
+    static SemaphoreHandle_t verify_lock = NULL;
+
+    // NVS keys are limited to 15 characters, so relays are keyed by a hash of host:port
+    static String pinKey(const String& hostPort) {
+        uint32_t hash = 2166136261UL;
+        for (unsigned int i = 0; i < hostPort.length(); i++) {
+            hash = (hash ^ (uint8_t)hostPort[i]) * 16777619UL;
+        }
+        char key[10];
+        snprintf(key, sizeof(key), "p%08lx", (unsigned long)hash);
+        return String(key);
+    }
+
+    static SessionPin* findSessionPin(const String& hostPort) {
+        for (int i = 0; i < Config::SESSION_PINS; i++) {
+            if (session_pins[i].valid && session_pins[i].hostPort == hostPort) {
+                return &session_pins[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Reuses the relay's own slot, then a free one, then the oldest
+    static void rememberSessionPin(const String& hostPort, const uint8_t* hash) {
+        SessionPin* slot = findSessionPin(hostPort);
+        for (int i = 0; slot == nullptr && i < Config::SESSION_PINS; i++) {
+            if (!session_pins[i].valid) {
+                slot = &session_pins[i];
+            }
+        }
+        if (slot == nullptr) {
+            slot = &session_pins[next_session_slot];
+            next_session_slot = (next_session_slot + 1) % Config::SESSION_PINS;
+        }
+        slot->hostPort = hostPort;
+        memcpy(slot->hash, hash, sizeof(slot->hash));
+        slot->valid = true;
+    }
+
+    static String toHexString(const uint8_t* bytes, size_t length) {
+        String hex = "";
+        for (size_t i = 0; i < length; i++) {
+            hex += "0123456789abcdef"[bytes[i] >> 4];
+            hex += "0123456789abcdef"[bytes[i] & 0x0F];
+        }
+        return hex;
+    }
+
+    void init() {
+        if (verify_lock == NULL) {
+            verify_lock = xSemaphoreCreateMutex();
+        }
+
+        Preferences prefs;
+        prefs.begin(Config::PREFS_NAMESPACE, true);
+        verify_mode = (verify_mode_t)prefs.getUChar(Config::MODE_KEY, Config::DEFAULT_MODE);
+        prefs.end();
+
+        if (verify_mode == TLS_VERIFY_CHAIN && !isChainAvailable()) {
+            Serial.println("CertPins::init() - No CA bundle in this build, using pin mode");
+            verify_mode = TLS_VERIFY_PIN;
+        }
+        Serial.println("CertPins::init() - Relay TLS verification: " + String(getModeName(verify_mode)));
+    }
+
+    verify_mode_t getMode() {
+        return verify_mode;
+    }
+
+    void setMode(verify_mode_t mode) {
+        if (mode == TLS_VERIFY_CHAIN && !isChainAvailable()) {
+            Serial.println("CertPins::setMode() - No CA bundle in this build, using pin mode");
+            mode = TLS_VERIFY_PIN;
+        }
+        verify_mode = mode;
+
+        Preferences prefs;
+        if (prefs.begin(Config::PREFS_NAMESPACE, false)) {
+            prefs.putUChar(Config::MODE_KEY, mode);
+            prefs.end();
+        }
+        Serial.println("CertPins::setMode() - Relay TLS verification: " + String(getModeName(mode)));
+    }
+
+    const char* getModeName(verify_mode_t mode) {
+        switch (mode) {
+            case TLS_VERIFY_NONE:
+                return "none";
+            case TLS_VERIFY_CHAIN:
+                return "chain";
+            default:
+                return "pin";
+        }
+    }
+
+    bool isChainAvailable() {
+#ifdef RELAY_CA_BUNDLE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static bool verifyPeerLocked(const String& hostPort, const mbedtls_x509_crt* cert) {
+        if (cert == nullptr) {
+            Serial.println("CertPins::verifyPeer() - No peer certificate from " + hostPort);
+            Metrics::increment("signer_relay_pin_failures_total");
+            return false;
+        }
+
+        unsigned long start = micros();
+        uint8_t hash[32];
+        mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), cert->pk_raw.p, cert->pk_raw.len, hash);
+
+        // Same key as earlier this boot: no NVS access needed
+        SessionPin* session = findSessionPin(hostPort);
+        if (session != nullptr && memcmp(session->hash, hash, sizeof(hash)) == 0) {
+            Metrics::increment("signer_relay_pin_session_hits_total");
+            Metrics::observe("signer_relay_pin_check_us", micros() - start);
+            return true;
+        }
+
+        String key = pinKey(hostPort);
+        uint8_t stored[32];
+        Preferences prefs;
+        prefs.begin(Config::PREFS_NAMESPACE, false);
+        size_t storedLength = prefs.getBytesLength(key.c_str()) == sizeof(stored) ? prefs.getBytes(key.c_str(), stored, sizeof(stored)) : 0;
+
+        bool accepted;
+        if (storedLength == 0) {
+            prefs.putBytes(key.c_str(), hash, sizeof(hash));
+            Serial.println("CertPins::verifyPeer() - Pinned " + hostPort + " to SPKI sha256 " + toHexString(hash, sizeof(hash)));
+            Metrics::increment("signer_relay_pins_created_total");
+            accepted = true;
+        } else {
+            accepted = memcmp(stored, hash, sizeof(hash)) == 0;
+        }
+        prefs.end();
+
+        Metrics::observe("signer_relay_pin_check_us", micros() - start);
+        if (!accepted) {
+            Serial.println("CertPins::verifyPeer() - REJECTED " + hostPort + ": key sha256 " + toHexString(hash, sizeof(hash)) + " does not match pin " + toHexString(stored, sizeof(stored)) + "; forget the pin on the AP page if the relay renewed its key");
+            Metrics::increment("signer_relay_pin_failures_total");
+            return false;
+        }
+
+        rememberSessionPin(hostPort, hash);
+        return true;
+    }
+
+    bool verifyPeer(const String& hostPort, const mbedtls_x509_crt* cert) {
+        if (verify_lock == NULL) {
+            return verifyPeerLocked(hostPort, cert);
+        }
+        xSemaphoreTake(verify_lock, portMAX_DELAY);
+        bool accepted = verifyPeerLocked(hostPort, cert);
+        xSemaphoreGive(verify_lock);
+        return accepted;
+    }
+
+    void forget(const String& hostPort) {
+        Preferences prefs;
+        if (prefs.begin(Config::PREFS_NAMESPACE, false)) {
+            prefs.remove(pinKey(hostPort).c_str());
+            prefs.end();
+        }
+        if (verify_lock != NULL) {
+            xSemaphoreTake(verify_lock, portMAX_DELAY);
+        }
+        SessionPin* session = findSessionPin(hostPort);
+        if (session != nullptr) {
+            session->valid = false;
+        }
+        if (verify_lock != NULL) {
+            xSemaphoreGive(verify_lock);
+        }
+        Serial.println("CertPins::forget() - Pin for " + hostPort + " cleared; next connection will pin again");
+    }
+
+    String getPinHex(const String& hostPort) {
+        uint8_t stored[32];
+        Preferences prefs;
+        prefs.begin(Config::PREFS_NAMESPACE, true);
+        size_t length = prefs.getBytesLength(pinKey(hostPort).c_str()) == sizeof(stored) ? prefs.getBytes(pinKey(hostPort).c_str(), stored, sizeof(stored)) : 0;
+        prefs.end();
+        return length == sizeof(stored) ? toHexString(stored, sizeof(stored)) : String("");
+    }
+}
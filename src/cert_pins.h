@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include <mbedtls/x509_crt.h>
+
+#ifdef RELAY_CA_BUNDLE
+// CA bundle for chain validation, linked in with board_build.embed_files = data/cert/x509_crt_bundle.bin
+extern const uint8_t relay_ca_bundle_start[] asm("_binary_data_cert_x509_crt_bundle_bin_start");
+extern const uint8_t relay_ca_bundle_end[] asm("_binary_data_cert_x509_crt_bundle_bin_end");
+#endif
+
+/**
+ * Relay TLS verification by SPKI pinning.
+ *
+ * In pin mode the SHA-256 of the leaf certificate's SubjectPublicKeyInfo
+ * is compared with the pin stored in NVS for host:port, so a handshake
+ * costs one hash instead of a chain walk. A relay is pinned the first
+ * time it is connected to (or after its pin was forgotten). Accepted
+ * hashes are kept in a small RAM table keyed by host:port, so later
+ * reconnects to any relay in the same boot match without touching NVS.
+ *
+ * Pinning is opt-in: a relay that renews its key is refused until its pin
+ * is forgotten on the AP page. The default is chain mode, which verifies
+ * against the CA bundle from gen_ca_bundle.py, linked in by the stock envs
+ * with -DRELAY_CA_BUNDLE and survives key renewals. Builds without the
+ * bundle fall back to pin mode.
+ */
+namespace CertPins {
+    typedef enum {
+        TLS_VERIFY_NONE,
+        TLS_VERIFY_PIN,
+        TLS_VERIFY_CHAIN
+    } verify_mode_t;
+
+    void init();
+    verify_mode_t getMode();
+    void setMode(verify_mode_t mode);   // Persisted
+    const char* getModeName(verify_mode_t mode);
+    bool isChainAvailable();
+
+    // WebSocketsClient peer certificate check for the relay at hostPort
+    bool verifyPeer(const String& hostPort, const mbedtls_x509_crt* cert);
+
+    // Drops the stored pin; the next connection pins the key it presents
+    void forget(const String& hostPort);
+    String getPinHex(const String& hostPort);
+
+    namespace Config {
+        const char* const PREFS_NAMESPACE = "relay_pins";
+        const verify_mode_t DEFAULT_MODE = TLS_VERIFY_CHAIN;
+        // Was "mode" while pin was the default; every saved AP form stored it,
+        // so the old key cannot tell a choice from the old default
+        const char* const MODE_KEY = "verify";
+        const int SESSION_PINS = 4;     // Signer relay plus RelayPool::Config::MAX_RELAYS
+    }
+}
@@ -1,5 +1,8 @@
 #include "display.h"
 #include "app.h"
+#include "metrics.h"
+#include "ui_latency.h"
+#include <signer_trace.h>
 #include <Arduino.h>
 
 // Forward declarations for external UI elements from ui.cpp
@@ -156,6 +159,7 @@ namespace Display {
         disp_drv.hor_res = screenWidth;
         disp_drv.ver_res = screenHeight;
         disp_drv.flush_cb = displayFlush;
+        disp_drv.monitor_cb = renderMonitor;
         disp_drv.draw_buf = &draw_buf;
         lv_disp_drv_register(&disp_drv);
 
@@ -169,6 +173,7 @@ namespace Display {
         indev_drv.read_timer = NULL; // Let LVGL create its own timer
         
         lv_indev_t *indev = lv_indev_drv_register(&indev_drv);
+        UiLatency::attachInput(indev);
         
         if (indev) {
             Serial.println("LVGL input device registered successfully");
@@ -189,12 +194,21 @@ namespace Display {
         uint32_t w = lv_area_get_width(area);
         uint32_t h = lv_area_get_height(area);
 
+        TRACE_SCOPE("lvgl_flush");
+        UiLatency::flushStarted();
         gfx->draw16bitRGBBitmap(area->x1, area->y1, (uint16_t *)color_p, w, h);
         gfx->flush();
 
         lv_disp_flush_ready(disp);
     }
 
+    // Called by LVGL after each refresh with the time spent rendering and flushing
+    void renderMonitor(lv_disp_drv_t *disp, uint32_t time_ms, uint32_t px) {
+        Metrics::observe("lvgl_render_duration_ms", time_ms);
+        Metrics::observe("lvgl_render_pixels", px);
+        UiLatency::refreshFinished();
+    }
+
     // Touchpad callback to read the touchpad
     void touchpadRead(lv_indev_drv_t *indev_driver, lv_indev_data_t *data) {
         static bool last_touch_state = false;
@@ -218,6 +232,11 @@ namespace Display {
             // Read touched point from touch module
             touch.readData(&touchX, &touchY);
 
+            // Start a touch-to-photon trace on each new press
+            if (!last_touch_state) {
+                UiLatency::touchPressed(touch.lastInterruptMicros());
+            }
+
             // Set the coordinates (LVGL will handle object detection and events automatically)
             data->point.x = touchX;
             data->point.y = touchY;
@@ -36,6 +36,7 @@ namespace Display {
     // Display driver callbacks
     void displayFlush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p);
     void touchpadRead(lv_indev_drv_t *indev_driver, lv_indev_data_t *data);
+    void renderMonitor(lv_disp_drv_t *disp, uint32_t time_ms, uint32_t px);
     
     // QR Code display functions
     void displayQRCode(const String& invoice);
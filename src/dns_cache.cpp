@@ -0,0 +1,277 @@
+#include "dns_cache.h"
+#include "metrics.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+namespace DnsCache {
+    struct Entry {
+        String host;
+        IPAddress addresses[Config::MAX_ADDRESSES];
+        int count = 0;
+        unsigned long expires = 0;
+        unsigned long lastUsed = 0;
+    };
+
+    static Entry entries[Config::MAX_HOSTS];
+
+    static Entry* findEntry(const String& host) {
+        for (int i = 0; i < Config::MAX_HOSTS; i++) {
+            if (entries[i].count > 0 && entries[i].host == host) {
+                return &entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Reuses an empty slot or evicts the least recently used host
+    static Entry* allocateEntry(const String& host) {
+        Entry* victim = &entries[0];
+        for (int i = 0; i < Config::MAX_HOSTS; i++) {
+            if (entries[i].count == 0) {
+                victim = &entries[i];
+                break;
+            }
+            if (entries[i].lastUsed < victim->lastUsed) {
+                victim = &entries[i];
+            }
+        }
+        victim->host = host;
+        victim->count = 0;
+        return victim;
+    }
+
+    // Returns the offset just past a (possibly compressed) name, or -1 if malformed
+    static int skipName(const uint8_t* packet, int length, int offset) {
+        while (offset < length) {
+            uint8_t labelLength = packet[offset];
+            if (labelLength == 0) {
+                return offset + 1;
+            }
+            if ((labelLength & 0xC0) == 0xC0) {
+                return offset + 2 <= length ? offset + 2 : -1;
+            }
+            offset += labelLength + 1;
+        }
+        return -1;
+    }
+
+    // Direct A query to the resolver handed out by DHCP
+    static int queryResolver(const String& host, IPAddress* addresses, int maxAddresses, uint32_t& ttl) {
+        IPAddress resolver = WiFi.dnsIP();
+        if (resolver == IPAddress((uint32_t)0)) {
+            return 0;
+        }
+
+        // Random id and a fresh ephemeral port per query, so an off-path
+        // host has to guess both to slip in a forged answer
+        uint8_t packet[512];
+        uint16_t queryId = esp_random() & 0xFFFF;
+        int length = 0;
+        packet[length++] = queryId >> 8;
+        packet[length++] = queryId & 0xFF;
+        packet[length++] = 0x01; // Recursion desired
+        packet[length++] = 0x00;
+        packet[length++] = 0x00; packet[length++] = 0x01; // QDCOUNT
+        for (int i = 0; i < 6; i++) {
+            packet[length++] = 0x00;                      // ANCOUNT, NSCOUNT, ARCOUNT
+        }
+
+        int labelStart = 0;
+        while (labelStart <= (int)host.length()) {
+            int labelEnd = host.indexOf('.', labelStart);
+            if (labelEnd < 0) {
+                labelEnd = host.length();
+            }
+            int labelLength = labelEnd - labelStart;
+            if (labelLength == 0 || labelLength > 63 || length + labelLength + 6 > (int)sizeof(packet)) {
+                return 0;
+            }
+            packet[length++] = labelLength;
+            memcpy(packet + length, host.c_str() + labelStart, labelLength);
+            length += labelLength;
+            labelStart = labelEnd + 1;
+        }
+        packet[length++] = 0x00;
+        packet[length++] = 0x00; packet[length++] = 0x01; // QTYPE A
+        packet[length++] = 0x00; packet[length++] = 0x01; // QCLASS IN
+
+        int queryLength = length;
+        uint8_t query[512];
+        memcpy(query, packet, queryLength);
+
+        WiFiUDP udp;
+        if (!udp.begin(0)) {
+            return 0;
+        }
+        udp.beginPacket(resolver, 53);
+        udp.write(packet, length);
+        if (!udp.endPacket()) {
+            udp.stop();
+            return 0;
+        }
+
+        int responseLength = 0;
+        unsigned long start = millis();
+        while (millis() - start < Config::QUERY_TIMEOUT_MS) {
+            if (udp.parsePacket() > 0) {
+                // Only the resolver we asked, answering our id and echoing our question
+                bool fromResolver = udp.remoteIP() == resolver && udp.remotePort() == 53;
+                responseLength = udp.read(packet, sizeof(packet));
+                if (fromResolver && responseLength >= queryLength && ((packet[0] << 8) | packet[1]) == queryId &&
+                    memcmp(packet + 12, query + 12, queryLength - 12) == 0) {
+                    break;
+                }
+                Metrics::increment("signer_dns_rejected_responses_total");
+                responseLength = 0;
+            }
+            delay(5);
+        }
+        udp.stop();
+
+        // Must be a response with RCODE 0
+        if (responseLength < 12 || !(packet[2] & 0x80) || (packet[3] & 0x0F) != 0) {
+            return 0;
+        }
+
+        int questions = (packet[4] << 8) | packet[5];
+        int answers = (packet[6] << 8) | packet[7];
+        int offset = 12;
+        for (int i = 0; i < questions && offset >= 0; i++) {
+            offset = skipName(packet, responseLength, offset);
+            if (offset >= 0) {
+                offset += 4;
+            }
+        }
+
+        int count = 0;
+        ttl = Config::MAX_TTL_S;
+        for (int i = 0; i < answers && offset >= 0 && count < maxAddresses; i++) {
+            offset = skipName(packet, responseLength, offset);
+            if (offset < 0 || offset + 10 > responseLength) {
+                break;
+            }
+            uint16_t type = (packet[offset] << 8) | packet[offset + 1];
+            uint32_t recordTtl = ((uint32_t)packet[offset + 4] << 24) | ((uint32_t)packet[offset + 5] << 16) |
+                                 ((uint32_t)packet[offset + 6] << 8) | packet[offset + 7];
+            uint16_t dataLength = (packet[offset + 8] << 8) | packet[offset + 9];
+            offset += 10;
+            if (offset + dataLength > responseLength) {
+                break;
+            }
+            // CNAME records in front of the A records are skipped
+            if (type == 1 && dataLength == 4) {
+                addresses[count++] = IPAddress(packet[offset], packet[offset + 1], packet[offset + 2], packet[offset + 3]);
+                ttl = min(ttl, recordTtl);
+            }
+            offset += dataLength;
+        }
+        return count;
+    }
+
+    static int copyAddresses(const Entry& entry, IPAddress* addresses, int maxAddresses) {
+        int count = min(entry.count, maxAddresses);
+        for (int i = 0; i < count; i++) {
+            addresses[i] = entry.addresses[i];
+        }
+        return count;
+    }
+
+    int resolve(const String& host, IPAddress* addresses, int maxAddresses) {
+        // LAN relays are often configured by address
+        IPAddress literal;
+        if (maxAddresses > 0 && literal.fromString(host)) {
+            addresses[0] = literal;
+            return 1;
+        }
+
+        Entry* entry = findEntry(host);
+        if (entry != nullptr && (long)(entry->expires - millis()) > 0) {
+            entry->lastUsed = millis();
+            Metrics::increment("signer_dns_cache_hits_total");
+            return copyAddresses(*entry, addresses, maxAddresses);
+        }
+
+        IPAddress fresh[Config::MAX_ADDRESSES];
+        uint32_t ttl = Config::FALLBACK_TTL_S;
+        unsigned long start = millis();
+        int count = queryResolver(host, fresh, Config::MAX_ADDRESSES, ttl);
+        if (count == 0) {
+            // lwIP's resolver still works when the direct query is filtered
+            IPAddress address;
+            if (WiFi.hostByName(host.c_str(), address) == 1) {
+                fresh[0] = address;
+                count = 1;
+                ttl = Config::FALLBACK_TTL_S;
+            }
+        }
+        Metrics::observe("signer_dns_resolve_duration_ms", millis() - start);
+
+        if (count == 0) {
+            if (entry != nullptr) {
+                Serial.println("DnsCache::resolve() - Lookup failed for " + host + ", serving stale addresses");
+                Metrics::increment("signer_dns_stale_served_total");
+                entry->lastUsed = millis();
+                return copyAddresses(*entry, addresses, maxAddresses);
+            }
+            Serial.println("DnsCache::resolve() - Lookup failed for " + host);
+            Metrics::increment("signer_dns_failures_total");
+            return 0;
+        }
+
+        // Keep the address that last worked at the front if it is still published
+        IPAddress preferred = entry != nullptr ? entry->addresses[0] : IPAddress((uint32_t)0);
+        for (int i = 1; i < count; i++) {
+            if (fresh[i] == preferred) {
+                fresh[i] = fresh[0];
+                fresh[0] = preferred;
+                break;
+            }
+        }
+
+        if (entry == nullptr) {
+            entry = allocateEntry(host);
+        }
+        ttl = constrain(ttl, Config::MIN_TTL_S, Config::MAX_TTL_S);
+        for (int i = 0; i < count; i++) {
+            entry->addresses[i] = fresh[i];
+        }
+        entry->count = count;
+        entry->expires = millis() + ttl * 1000;
+        entry->lastUsed = millis();
+
+        Serial.println("DnsCache::resolve() - " + host + " -> " + String(count) + " address(es), first " + fresh[0].toString() + ", TTL " + String(ttl) + " s");
+        return copyAddresses(*entry, addresses, maxAddresses);
+    }
+
+    void markGood(const String& host, const IPAddress& address) {
+        Entry* entry = findEntry(host);
+        if (entry == nullptr) {
+            return;
+        }
+        for (int i = 1; i < entry->count; i++) {
+            if (entry->addresses[i] == address) {
+                entry->addresses[i] = entry->addresses[0];
+                entry->addresses[0] = address;
+                return;
+            }
+        }
+    }
+
+    void demote(const String& host, const IPAddress& address) {
+        Entry* entry = findEntry(host);
+        if (entry == nullptr || entry->count < 2) {
+            return;
+        }
+        for (int i = 0; i < entry->count - 1; i++) {
+            if (entry->addresses[i] == address) {
+                for (int j = i; j < entry->count - 1; j++) {
+                    entry->addresses[j] = entry->addresses[j + 1];
+                }
+                entry->addresses[entry->count - 1] = address;
+                Metrics::increment("signer_relay_address_fallbacks_total");
+                Serial.println("DnsCache::demote() - " + address.toString() + " failed, trying " + entry->addresses[0].toString() + " next");
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+/**
+ * Relay hostname cache with per-address fallback.
+ *
+ * A records are fetched with a direct query to the DHCP-provided resolver
+ * so every address and its TTL are available (lwIP keeps only one address
+ * per name and hides the TTL). Answers are only taken from the resolver's
+ * address and port 53, with a random query id and the question echoed
+ * back. Entries are served until their TTL runs out; if a refresh then
+ * fails, the stale addresses are served rather than failing the reconnect. The address that last connected is always tried
+ * first; one that fails to connect is moved to the back, so the next
+ * attempt tries another published address without a new lookup.
+ *
+ * Only used from the RelayLink network task, so lookups never block the
+ * loop task and the cache needs no lock.
+ */
+namespace DnsCache {
+    // Fills addresses (last-good first) and returns how many, 0 on failure
+    int resolve(const String& host, IPAddress* addresses, int maxAddresses);
+    void markGood(const String& host, const IPAddress& address);
+    // Moves an address that failed to connect behind the others; the entry
+    // and its stale fallback are kept
+    void demote(const String& host, const IPAddress& address);
+
+    namespace Config {
+        const int MAX_HOSTS = 4;
+        const int MAX_ADDRESSES = 4;
+        const uint32_t MIN_TTL_S = 30;
+        const uint32_t MAX_TTL_S = 3600;
+        const uint32_t FALLBACK_TTL_S = 300;          // hostByName() results carry no TTL
+        const unsigned long QUERY_TIMEOUT_MS = 2000;
+    }
+}
@@ -0,0 +1,136 @@
+/**
+ * @file display_headless.cpp
+ * @brief Display backend for headless builds (SIGNER_HEADLESS)
+ *
+ * Replaces display.cpp when there is no panel or touch controller. LVGL is
+ * still initialised against a virtual display so UI, WiFiManager and
+ * Settings code keeps running unchanged, but the refresh timer is paused
+ * so no rendering work is done outside of synthetic touch traces.
+ *
+ * Presses injected with UiLatency::injectTouch() (POST /touch on the
+ * metrics server) are fed through a pointer input device; rendering is
+ * resumed until the trace completes so touch-to-photon stages can be
+ * measured without a panel.
+ */
+
+#include "../display.h"
+#include "../ui_latency.h"
+
+namespace Display {
+    Arduino_DataBus *bus = nullptr;
+    Arduino_GFX *g = nullptr;
+    Arduino_Canvas *gfx = nullptr;
+    AXS15231B_Touch touch(Touch_SCL, Touch_SDA, Touch_INT, Touch_ADDR, TFT_rot);
+
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t *buf1 = nullptr;
+    static lv_timer_t *refr_timer = nullptr;
+
+    void init() {
+        Serial.println("=== Initializing headless display ===");
+        lv_init();
+        setupLVGL();
+    }
+
+    void cleanup() {
+        if (buf1 != nullptr) {
+            heap_caps_free(buf1);
+            buf1 = nullptr;
+        }
+        Serial.println("Display module cleaned up");
+    }
+
+    void setRotation(int rotation) {}
+
+    void setupLVGL() {
+        // LVGL needs a draw buffer to register a display, even one that never renders
+        uint32_t bufSize = TFT_WIDTH * 10;
+        buf1 = (lv_color_t*)heap_caps_malloc(bufSize * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+        if (!buf1) {
+            Serial.println("ERROR: Failed to allocate LVGL display buffer!");
+            return;
+        }
+        lv_disp_draw_buf_init(&draw_buf, buf1, nullptr, bufSize);
+
+        static lv_disp_drv_t disp_drv;
+        lv_disp_drv_init(&disp_drv);
+        disp_drv.hor_res = TFT_WIDTH;
+        disp_drv.ver_res = TFT_HEIGHT;
+        disp_drv.flush_cb = displayFlush;
+        disp_drv.monitor_cb = renderMonitor;
+        disp_drv.draw_buf = &draw_buf;
+        lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+
+        refr_timer = _lv_disp_get_refr_timer(disp);
+        lv_timer_pause(refr_timer);
+
+        static lv_indev_drv_t indev_drv;
+        lv_indev_drv_init(&indev_drv);
+        indev_drv.type = LV_INDEV_TYPE_POINTER;
+        indev_drv.read_cb = touchpadRead;
+        UiLatency::attachInput(lv_indev_drv_register(&indev_drv));
+
+        Serial.println("LVGL initialized with headless backend (rendering disabled)");
+    }
+
+    void displayFlush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+        UiLatency::flushStarted();
+        lv_disp_flush_ready(disp);
+    }
+
+    void renderMonitor(lv_disp_drv_t *disp, uint32_t time_ms, uint32_t px) {
+        UiLatency::refreshFinished();
+        if (!UiLatency::isTracing()) {
+            lv_timer_pause(refr_timer);
+        }
+    }
+
+    // Holds each synthetic press for one read so LVGL sees a press and a release
+    void touchpadRead(lv_indev_drv_t *indev_driver, lv_indev_data_t *data) {
+        static bool pressed = false;
+        static lv_point_t point = {0, 0};
+
+        int16_t x, y;
+        uint32_t injectedMicros;
+        if (!pressed && UiLatency::takeInjectedTouch(x, y, injectedMicros)) {
+            point.x = x;
+            point.y = y;
+            pressed = true;
+            // Draw whatever was invalidated while paused before arming the
+            // trace, so it is not counted in this press's render stage
+            lv_refr_now(NULL);
+            UiLatency::touchPressed(injectedMicros);
+            lv_timer_resume(refr_timer);
+        } else {
+            pressed = false;
+        }
+
+        data->point = point;
+        data->state = pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+
+        // Traces that never redraw time out; stop rendering again
+        if (!pressed && !UiLatency::isTracing()) {
+            lv_timer_pause(refr_timer);
+        }
+    }
+
+    void displayQRCode(const String& invoice) {
+        Serial.println("Display::displayQRCode() - " + invoice);
+    }
+
+    void displayInvoiceTextFallback(const String& invoice) {}
+
+    void setQRCanvas(lv_obj_t* canvas) {}
+
+    void turnOffBacklight() {}
+
+    void turnOnBacklight() {}
+
+    void turnOnBacklightForSigning() {}
+
+    void initBacklightTimeout() {}
+
+    void resetBacklightTimeout() {}
+
+    void checkBacklightTimeout() {}
+}
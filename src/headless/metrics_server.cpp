@@ -0,0 +1,137 @@
+#include "metrics_server.h"
+#include <WebServer.h>
+
+#include "../metrics.h"
+#include "../wifi_manager.h"
+#include "../ui.h"
+#include "../ui_latency.h"
+#include "../load_generator.h"
+#include <signer_trace.h>
+
+namespace MetricsServer {
+    static WebServer metrics_server(Config::PORT);
+    static bool server_started = false;
+
+    static void handleMetrics() {
+        metrics_server.send(200, "text/plain; version=0.0.4", Metrics::render());
+    }
+
+#ifdef SIGNER_DIAGNOSTICS_TOKEN
+    // Diagnostics drive the UI and the loop, so they need the build's token
+    static bool checkToken() {
+        String token = metrics_server.header(Config::TOKEN_HEADER);
+        const char* expected = SIGNER_DIAGNOSTICS_TOKEN;
+        size_t length = strlen(expected);
+        uint8_t diff = token.length() == length ? 0 : 1;
+        for (size_t i = 0; i < length && i < token.length(); i++) {
+            diff |= token[i] ^ expected[i];
+        }
+        if (length == 0 || diff != 0) {
+            metrics_server.send(401, "text/plain", "diagnostics token required\n");
+            return false;
+        }
+        return true;
+    }
+
+    // Synthetic press for touch latency tracing: POST /touch?x=160&y=240
+    static void handleTouch() {
+        if (!checkToken()) {
+            return;
+        }
+        // A press must never answer a dialog, whatever opened it
+        if (UI::isConfirmationDialogOpen()) {
+            metrics_server.send(409, "text/plain", "a dialog is open\n");
+            return;
+        }
+        if (!metrics_server.hasArg("x") || !metrics_server.hasArg("y")) {
+            metrics_server.send(400, "text/plain", "x and y required\n");
+            return;
+        }
+        UiLatency::injectTouch(metrics_server.arg("x").toInt(), metrics_server.arg("y").toInt());
+        metrics_server.send(202, "text/plain", "queued\n");
+    }
+
+    static void handleLatency() {
+        if (!checkToken()) {
+            return;
+        }
+        metrics_server.send(200, "text/plain", UiLatency::getReport());
+    }
+
+    // Memory soak: POST /soak?requests=1000000 starts a run, GET /soak reports it
+    static void handleSoakStart() {
+        if (!checkToken()) {
+            return;
+        }
+        uint32_t requests = metrics_server.hasArg("requests") ? metrics_server.arg("requests").toInt() : LoadGenerator::Config::SOAK_REQUESTS;
+        if (!LoadGenerator::startSoak(requests)) {
+            metrics_server.send(409, "text/plain", "load test already running or keys not configured\n");
+            return;
+        }
+        metrics_server.send(202, "text/plain", "started\n");
+    }
+#endif
+
+    static void handleSoakReport() {
+        metrics_server.send(200, "text/plain", LoadGenerator::getSoakReport());
+    }
+
+    // Buffers the trace export into chunked HTTP responses
+    class ChunkedResponse : public Print {
+    public:
+        size_t write(uint8_t c) override {
+            buffer[length++] = c;
+            if (length == sizeof(buffer)) {
+                flush();
+            }
+            return 1;
+        }
+        void flush() override {
+            if (length > 0) {
+                metrics_server.sendContent((const char*)buffer, length);
+                length = 0;
+            }
+        }
+    private:
+        uint8_t buffer[1024];
+        size_t length = 0;
+    };
+
+    // Chrome/Perfetto trace of the most recent events: GET /trace
+    static void handleTrace() {
+        if (Trace::isExporting()) {
+            metrics_server.send(409, "text/plain", "Trace export in progress\n");
+            return;
+        }
+        metrics_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        metrics_server.send(200, "application/json", "");
+        ChunkedResponse response;
+        Trace::exportJson(response);
+        response.flush();
+        metrics_server.sendContent("");
+    }
+
+    void processLoop() {
+        if (!WiFiManager::isConnected()) {
+            return;
+        }
+
+        if (!server_started) {
+            metrics_server.on("/metrics", HTTP_GET, handleMetrics);
+#ifdef SIGNER_DIAGNOSTICS_TOKEN
+            const char* headers[] = { Config::TOKEN_HEADER };
+            metrics_server.collectHeaders(headers, 1);
+            metrics_server.on("/touch", HTTP_POST, handleTouch);
+            metrics_server.on("/latency", HTTP_GET, handleLatency);
+            metrics_server.on("/soak", HTTP_POST, handleSoakStart);
+#endif
+            metrics_server.on("/soak", HTTP_GET, handleSoakReport);
+            metrics_server.on("/trace", HTTP_GET, handleTrace);
+            metrics_server.begin();
+            server_started = true;
+            Serial.println("MetricsServer::processLoop() - Serving metrics on http://" + WiFiManager::getLocalIP() + ":" + String(Config::PORT) + "/metrics");
+        }
+
+        metrics_server.handleClient();
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Prometheus scrape endpoint for headless builds (SIGNER_HEADLESS).
+ * Serves Metrics::render() at http://<device-ip>:9100/metrics once WiFi is up,
+ * and GET /soak for the memory soak report (LoadGenerator::getSoakReport()).
+ *
+ * Built with -DSIGNER_DIAGNOSTICS_TOKEN=\"...\", it also serves POST /touch?x=&y=
+ * to inject synthetic presses, GET /latency for the touch-to-photon report
+ * and POST /soak to start a soak (LoadGenerator::startSoak()). These need the
+ * token in the X-Diagnostics-Token header; without the flag they are not
+ * compiled in.
+ */
+namespace MetricsServer {
+    void processLoop();
+
+    namespace Config {
+        const uint16_t PORT = 9100;
+        const char* const TOKEN_HEADER = "X-Diagnostics-Token";
+    }
+}
@@ -0,0 +1,405 @@
+#include "load_generator.h"
+#include "remote_signer.h"
+#include "peer_coordinator.h"
+#include "metrics.h"
+#include <algorithm>
+#include <esp_heap_caps.h>
+
+#include "../lib/nostr/nostr.h"
+#include "../lib/nostr/envelope.h"
+#include "../lib/nostr/nip44/nip44.h"
+
+namespace LoadGenerator {
+    typedef enum {
+        METHOD_CONNECT,
+        METHOD_SIGN_EVENT,
+        METHOD_PING,
+        METHOD_GET_PUBLIC_KEY,
+        METHOD_NIP04_ENCRYPT,
+        METHOD_NIP04_DECRYPT,
+        METHOD_NIP44_ENCRYPT,
+        METHOD_NIP44_DECRYPT,
+        METHOD_COUNT
+    } method_t;
+
+    // Indexed by method_t
+    static const char* const METHOD_NAMES[METHOD_COUNT] = {
+        "connect",
+        "sign_event",
+        "ping",
+        "get_public_key",
+        "nip04_encrypt",
+        "nip04_decrypt",
+        "nip44_encrypt",
+        "nip44_decrypt"
+    };
+    static const int REQUEST_COUNT = METHOD_COUNT * 2; // Each method in both envelope schemes
+    static const char* const PLAINTEXT = "loopback load test payload";
+
+    struct Request {
+        String message;
+        uint8_t method = 0;
+    };
+
+    struct MethodStats {
+        uint32_t samples[Config::SAMPLES_PER_METHOD];
+        int next = 0;
+        int count = 0;
+    };
+
+    struct MemorySnapshot {
+        uint32_t request = 0;
+        int32_t heap = 0;           // Free 8-bit capable heap, internal and PSRAM
+        int32_t psram = 0;
+        int32_t largestBlock = 0;
+        int32_t blocks = 0;         // Allocated blocks
+    };
+
+    // Net memory retained across bracketed requests of one method
+    struct Attribution {
+        int64_t bytes = 0;
+        int64_t blocks = 0;
+        uint32_t samples = 0;
+    };
+
+    static String client_private_keys[Config::CLIENT_COUNT];
+    static String client_public_keys[Config::CLIENT_COUNT];
+    static Request requests[REQUEST_COUNT];
+    static MethodStats stats[METHOD_COUNT];
+
+    static bool running = false;
+    static int next_request = 0;
+    static unsigned long completed = 0;
+    static unsigned long start_time = 0;
+    static unsigned long last_report = 0;
+    static unsigned long stop_time = 0;
+    static int32_t start_heap = 0;
+    static int32_t start_psram = 0;
+
+    static bool soaking = false;
+    static bool soak_has_baseline = false;
+    static bool soak_finished = false;
+    static bool soak_passed = false;
+    static uint32_t soak_target = 0;
+    static MemorySnapshot soak_baseline;
+    static MemorySnapshot soak_latest;
+    static int32_t soak_min_largest_block = 0;
+    static MemorySnapshot soak_trend[Config::SOAK_TREND_SAMPLES];
+    static int soak_trend_next = 0;
+    static int soak_trend_count = 0;
+    static Attribution attribution[METHOD_COUNT];
+
+    static void generateClientKey(int index) {
+        String privateKeyHex = "";
+        for (int i = 0; i < 64; i++) {
+            privateKeyHex += "0123456789abcdef"[esp_random() % 16];
+        }
+
+        byte privateKeyBytes[32];
+        fromHex(privateKeyHex, privateKeyBytes, 32);
+        PrivateKey privKey(privateKeyBytes);
+        client_private_keys[index] = privateKeyHex;
+        client_public_keys[index] = privKey.publicKey().toString().substring(2);
+    }
+
+    // Params for each method; the third party for encrypt/decrypt is another simulated client
+    static String buildParams(int method, int client) {
+        int thirdParty = (client + 1) % Config::CLIENT_COUNT;
+        String thirdPartyPub = client_public_keys[thirdParty];
+        String userPub = RemoteSigner::getUserPublicKey();
+        String plaintext = PLAINTEXT;
+
+        switch (method) {
+            case METHOD_CONNECT:
+                return "[\"" + RemoteSigner::getDevicePublicKey() + "\",\"\"]";
+            case METHOD_SIGN_EVENT:
+                return "[\"{\\\"kind\\\":1,\\\"content\\\":\\\"" + plaintext + "\\\",\\\"tags\\\":[],\\\"created_at\\\":" + String(RemoteSigner::getUnixTimestamp()) + "}\"]";
+            case METHOD_NIP04_ENCRYPT:
+            case METHOD_NIP44_ENCRYPT:
+                return "[\"" + thirdPartyPub + "\",\"" + plaintext + "\"]";
+            case METHOD_NIP04_DECRYPT:
+                return "[\"" + thirdPartyPub + "\",\"" + nostr::getCipherText(client_private_keys[thirdParty].c_str(), userPub.c_str(), plaintext) + "\"]";
+            case METHOD_NIP44_DECRYPT:
+                return "[\"" + thirdPartyPub + "\",\"" + executeEncryptMessageNip44(plaintext, client_private_keys[thirdParty], userPub) + "\"]";
+            default:
+                return "[]";
+        }
+    }
+
+    static void buildRequests() {
+        String devicePub = RemoteSigner::getDevicePublicKey();
+        unsigned long timestamp = RemoteSigner::getUnixTimestamp();
+
+        for (int i = 0; i < REQUEST_COUNT; i++) {
+            int method = i % METHOD_COUNT;
+            int client = i % Config::CLIENT_COUNT;
+            const char* priv = client_private_keys[client].c_str();
+            const char* pub = client_public_keys[client].c_str();
+
+            String request = "{\"id\":\"lg" + String(i) + "\",\"method\":\"" + String(METHOD_NAMES[method]) + "\",\"params\":" + buildParams(method, client) + "}";
+            String event = i < METHOD_COUNT
+                ? nostr::getEncryptedDm<nostr::Nip04Scheme>(priv, pub, devicePub.c_str(), 24133, timestamp, request)
+                : nostr::getEncryptedDm<nostr::Nip44Scheme>(priv, pub, devicePub.c_str(), 24133, timestamp, request);
+
+            // Relays deliver events with the subscription id in front: ["EVENT","<sub>",{...}]
+            requests[i].message = "[\"EVENT\",\"loopback\"," + event.substring(9);
+            requests[i].method = method;
+        }
+    }
+
+    static MemorySnapshot takeSnapshot() {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+
+        MemorySnapshot snapshot;
+        snapshot.request = completed;
+        snapshot.heap = info.total_free_bytes;
+        snapshot.psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        snapshot.largestBlock = info.largest_free_block;
+        snapshot.blocks = info.allocated_blocks;
+        return snapshot;
+    }
+
+    static void finishSoak() {
+        soak_latest = takeSnapshot();
+        soak_min_largest_block = min(soak_min_largest_block, soak_latest.largestBlock);
+        soak_passed = soak_baseline.heap - soak_latest.heap <= Config::SOAK_HEAP_TOLERANCE &&
+                      soak_baseline.psram - soak_latest.psram <= Config::SOAK_HEAP_TOLERANCE &&
+                      soak_latest.blocks - soak_baseline.blocks <= Config::SOAK_BLOCK_TOLERANCE;
+        soak_finished = true;
+        soaking = false;
+        Metrics::setGauge("signer_soak_passed", soak_passed ? 1 : 0);
+        Serial.println("LoadGenerator - Soak " + String(soak_passed ? "PASSED" : "FAILED") + ":\n" + getSoakReport());
+        stop();
+    }
+
+    // Baseline after warm-up, then periodic trend samples until the target is reached
+    static void afterSoakRequest() {
+        if (!soak_has_baseline) {
+            if (completed >= Config::SOAK_WARMUP_REQUESTS) {
+                soak_baseline = takeSnapshot();
+                soak_latest = soak_baseline;
+                soak_min_largest_block = soak_baseline.largestBlock;
+                soak_has_baseline = true;
+                Serial.println("LoadGenerator - Soak baseline: heap " + String(soak_baseline.heap) + " B, PSRAM " + String(soak_baseline.psram) + " B, largest block " + String(soak_baseline.largestBlock) + " B, " + String(soak_baseline.blocks) + " blocks");
+            }
+            return;
+        }
+
+        uint32_t soaked = completed - soak_baseline.request;
+        if (soaked % Config::SOAK_SAMPLE_EVERY == 0) {
+            soak_latest = takeSnapshot();
+            soak_min_largest_block = min(soak_min_largest_block, soak_latest.largestBlock);
+            soak_trend[soak_trend_next] = soak_latest;
+            soak_trend_next = (soak_trend_next + 1) % Config::SOAK_TREND_SAMPLES;
+            if (soak_trend_count < Config::SOAK_TREND_SAMPLES) {
+                soak_trend_count++;
+            }
+            Metrics::setGauge("signer_soak_heap_drift_bytes", soak_latest.heap - soak_baseline.heap);
+            Metrics::setGauge("signer_soak_block_drift", soak_latest.blocks - soak_baseline.blocks);
+            Serial.println("LoadGenerator - Soak " + String(soaked) + "/" + String(soak_target) + ": heap " + String(soak_latest.heap - soak_baseline.heap) + " B, PSRAM " + String(soak_latest.psram - soak_baseline.psram) + " B, largest block " + String(soak_latest.largestBlock) + " B, blocks " + String(soak_latest.blocks - soak_baseline.blocks));
+        }
+        if (soaked >= soak_target) {
+            finishSoak();
+        }
+    }
+
+    static void replayNext() {
+        Request& request = requests[next_request];
+        next_request = (next_request + 1) % REQUEST_COUNT;
+
+        bool attribute = soaking && soak_has_baseline && completed % Config::SOAK_ATTRIBUTION_EVERY == 0;
+        MemorySnapshot before;
+        if (attribute) {
+            before = takeSnapshot();
+        }
+
+        unsigned long requestStart = micros();
+        RemoteSigner::handleWebsocketMessage(nullptr, (uint8_t*)request.message.c_str(), request.message.length());
+        uint32_t elapsed = micros() - requestStart;
+
+        if (attribute) {
+            MemorySnapshot after = takeSnapshot();
+            attribution[request.method].bytes += before.heap - after.heap;
+            attribution[request.method].blocks += after.blocks - before.blocks;
+            attribution[request.method].samples++;
+        }
+
+        MethodStats& methodStats = stats[request.method];
+        methodStats.samples[methodStats.next] = elapsed;
+        methodStats.next = (methodStats.next + 1) % Config::SAMPLES_PER_METHOD;
+        if (methodStats.count < Config::SAMPLES_PER_METHOD) {
+            methodStats.count++;
+        }
+        completed++;
+
+        if (soaking) {
+            afterSoakRequest();
+        }
+    }
+
+    bool start() {
+        if (running) {
+            return true;
+        }
+        if (RemoteSigner::getUserPublicKey().length() == 0 || RemoteSigner::getDevicePublicKey().length() == 0) {
+            Serial.println("LoadGenerator::start() - Signer keys not configured");
+            return false;
+        }
+        if (PeerCoordinator::isEnabled()) {
+            Serial.println("LoadGenerator::start() - Peer mode is on; requests owned by peers will be deferred");
+        }
+
+        Serial.println("LoadGenerator::start() - Building loopback requests...");
+        String loopbackClients = "";
+        for (int i = 0; i < Config::CLIENT_COUNT; i++) {
+            generateClientKey(i);
+            loopbackClients += (i > 0 ? "|" : "") + client_public_keys[i];
+        }
+        RemoteSigner::setLoopbackClients(loopbackClients);
+        buildRequests();
+
+        for (int i = 0; i < METHOD_COUNT; i++) {
+            stats[i].next = 0;
+            stats[i].count = 0;
+        }
+        next_request = 0;
+        completed = 0;
+        start_heap = ESP.getFreeHeap();
+        start_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        start_time = millis();
+        last_report = start_time;
+        running = true;
+
+        Serial.println("LoadGenerator::start() - Replaying " + String(REQUEST_COUNT) + " requests from " + String(Config::CLIENT_COUNT) + " simulated clients");
+        return true;
+    }
+
+    void stop() {
+        if (!running) {
+            return;
+        }
+        running = false;
+        stop_time = millis();
+        if (soaking) {
+            soaking = false;
+            Serial.println("LoadGenerator::stop() - Soak stopped before completion");
+        }
+        RemoteSigner::setLoopbackClients("");
+        for (int i = 0; i < REQUEST_COUNT; i++) {
+            requests[i].message = "";
+        }
+        Serial.println("LoadGenerator::stop() - Final report:\n" + getReport());
+    }
+
+    bool isRunning() {
+        return running;
+    }
+
+    void processLoop() {
+        if (!running) {
+            return;
+        }
+
+        // Always replay at least one request, then keep going until the budget is spent
+        unsigned long loopStart = millis();
+        do {
+            replayNext();
+        } while (running && millis() - loopStart < Config::LOOP_BUDGET_MS);
+
+        if (running && millis() - last_report >= Config::REPORT_INTERVAL) {
+            last_report = millis();
+            Serial.println("LoadGenerator - " + getReport());
+        }
+    }
+
+    bool startSoak(uint32_t target) {
+        if (running) {
+            Serial.println("LoadGenerator::startSoak() - Load test already running");
+            return false;
+        }
+
+        soak_has_baseline = false;
+        soak_finished = false;
+        soak_passed = false;
+        soak_target = target;
+        // A verdict from an earlier run must not be read as this one's
+        Metrics::setGauge("signer_soak_passed", 0);
+        soak_trend_next = 0;
+        soak_trend_count = 0;
+        for (int i = 0; i < METHOD_COUNT; i++) {
+            attribution[i] = Attribution();
+        }
+
+        if (!start()) {
+            return false;
+        }
+        soaking = true;
+        Serial.println("LoadGenerator::startSoak() - Soaking for " + String(target) + " requests after " + String(Config::SOAK_WARMUP_REQUESTS) + " warm-up requests");
+        return true;
+    }
+
+    bool isSoaking() {
+        return soaking;
+    }
+
+    String getSoakReport() {
+        if (!soaking && !soak_finished) {
+            return "Soak not run";
+        }
+        if (!soak_has_baseline) {
+            return "Soak warming up (" + String(completed) + "/" + String(Config::SOAK_WARMUP_REQUESTS) + ")";
+        }
+
+        uint32_t soaked = soak_latest.request - soak_baseline.request;
+        String report = soak_finished
+            ? "Soak " + String(soak_passed ? "PASSED" : "FAILED") + " after " + String(soaked) + " requests\n"
+            : "Soak " + String(soaked) + "/" + String(soak_target) + " requests\n";
+        report += "Heap " + String(soak_latest.heap - soak_baseline.heap) + " B, PSRAM " + String(soak_latest.psram - soak_baseline.psram) + " B, blocks " + String(soak_latest.blocks - soak_baseline.blocks) + "\n";
+        report += "Largest block " + String(soak_latest.largestBlock) + " B (min " + String(soak_min_largest_block) + " B)\n";
+
+        // Heap trend across the retained samples, oldest to newest
+        if (soak_trend_count >= 2) {
+            const MemorySnapshot& oldest = soak_trend[(soak_trend_next - soak_trend_count + Config::SOAK_TREND_SAMPLES) % Config::SOAK_TREND_SAMPLES];
+            const MemorySnapshot& newest = soak_trend[(soak_trend_next - 1 + Config::SOAK_TREND_SAMPLES) % Config::SOAK_TREND_SAMPLES];
+            float per100k = (float)(newest.heap - oldest.heap) * 100000.0f / (newest.request - oldest.request);
+            report += "Trend " + String(per100k, 0) + " B per 100k requests\n";
+        }
+
+        for (int i = 0; i < METHOD_COUNT; i++) {
+            if (attribution[i].samples == 0) {
+                continue;
+            }
+            float bytesPerCall = (float)attribution[i].bytes / attribution[i].samples;
+            float blocksPerCall = (float)attribution[i].blocks / attribution[i].samples;
+            report += String(METHOD_NAMES[i]) + ": " + String(bytesPerCall, 1) + " B, " + String(blocksPerCall, 2) + " blocks retained/call\n";
+        }
+        return report;
+    }
+
+    String getReport() {
+        if (start_time == 0) {
+            return "Load test not run";
+        }
+
+        unsigned long elapsed = (running ? millis() : stop_time) - start_time;
+        float rate = elapsed > 0 ? completed * 1000.0f / elapsed : 0;
+        int32_t heapDrift = (int32_t)ESP.getFreeHeap() - start_heap;
+        int32_t psramDrift = (int32_t)heap_caps_get_free_size(MALLOC_CAP_SPIRAM) - start_psram;
+
+        String report = String(completed) + " req in " + String(elapsed / 1000) + " s, " + String(rate, 1) + " req/s\n";
+        report += "Heap drift " + String(heapDrift) + " B, PSRAM drift " + String(psramDrift) + " B\n";
+
+        uint32_t sorted[Config::SAMPLES_PER_METHOD];
+        for (int i = 0; i < METHOD_COUNT; i++) {
+            int count = stats[i].count;
+            if (count == 0) {
+                continue;
+            }
+            memcpy(sorted, stats[i].samples, count * sizeof(uint32_t));
+            std::sort(sorted, sorted + count);
+            report += String(METHOD_NAMES[i]) + ": p50 " + String(sorted[(count - 1) * 50 / 100] / 1000.0f, 1) + " ms, p99 " + String(sorted[(count - 1) * 99 / 100] / 1000.0f, 1) + " ms\n";
+        }
+        return report;
+    }
+}
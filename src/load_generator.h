@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * On-device loopback load generator for measuring signing throughput.
+ *
+ * Encrypted kind-24133 requests covering every NIP-46 method are built
+ * once from a handful of simulated client keys, then replayed straight
+ * into RemoteSigner::handleWebsocketMessage() from the main loop. The
+ * signer treats the simulated clients as authorised and skips sending
+ * replies while a run is active, so the numbers include real ECDH,
+ * encryption, signing, flash and PSRAM costs but no relay round trip.
+ *
+ * Soak mode replays the same mix for a fixed number of requests and checks
+ * that memory comes back to where it started. A baseline of free heap,
+ * free PSRAM, largest free block and allocated block count is taken once
+ * the signer caches are warm; trend samples are logged as the run goes,
+ * and every SOAK_ATTRIBUTION_EVERY-th request is bracketed by heap
+ * snapshots so retained bytes and blocks can be attributed to a method.
+ * The run fails if the final figures have not returned to the baseline.
+ * Loopback requests skip the signed-events list, notifications and
+ * backlight (see RemoteSigner::setLoopbackClients), so any drift is the
+ * signer's own and not the harness filling the UI.
+ */
+namespace LoadGenerator {
+    // Run control
+    bool start();
+    void stop();
+    bool isRunning();
+    void processLoop();
+
+    // Soak run of the given number of requests; stops itself when done
+    bool startSoak(uint32_t requests);
+    bool isSoaking();
+
+    // Human-readable summary: throughput, per-method p50/p99 and heap drift
+    String getReport();
+    String getSoakReport();
+
+    namespace Config {
+        const int CLIENT_COUNT = 3;
+        const int SAMPLES_PER_METHOD = 128;        // Latency ring per method
+        const unsigned long LOOP_BUDGET_MS = 40;   // Replay time per main loop pass
+        const unsigned long REPORT_INTERVAL = 5000;
+
+        const uint32_t SOAK_REQUESTS = 1000000;
+        const uint32_t SOAK_WARMUP_REQUESTS = 256;     // Fills the key and ECDH caches before the baseline
+        const uint32_t SOAK_SAMPLE_EVERY = 10000;
+        const uint32_t SOAK_ATTRIBUTION_EVERY = 97;    // Coprime with the request count so every method is sampled
+        const int SOAK_TREND_SAMPLES = 32;
+        const int32_t SOAK_HEAP_TOLERANCE = 2048;      // Bytes
+        const int32_t SOAK_BLOCK_TOLERANCE = 8;
+    }
+}
@@ -48,15 +48,23 @@
 /*1: use custom malloc/free, 0: use the built-in `lv_mem_alloc()` and `lv_mem_free()`*/
 #define LV_MEM_CUSTOM 0
 #if LV_MEM_CUSTOM == 0
-/*Size of the memory available for `lv_mem_alloc()` in bytes (>= 2kB)*/
+/*Size of the memory available for `lv_mem_alloc()` in bytes (>= 2kB)
+ *The built-in allocator is TLSF. Its pool lives in PSRAM (see LV_MEM_POOL_ALLOC below), which leaves
+ *room for the settings screen and long event lists. Build with -DLVGL_MEM_INTERNAL to put the old 32 KB
+ *pool back in internal RAM when comparing render times.*/
+#ifdef LVGL_MEM_INTERNAL
 #  define LV_MEM_SIZE (32U * 1024U)          /*[bytes]*/
+#else
+#  define LV_MEM_SIZE (256U * 1024U)         /*[bytes]*/
+#endif
 
 /*Set an address for the memory pool instead of allocating it as a normal array. Can be in external SRAM too.*/
 #  define LV_MEM_ADR 0     /*0: unused*/
 /*Instead of an address give a memory allocator that will be called to get a memory pool for LVGL. E.g. my_malloc*/
-#if LV_MEM_ADR == 0
-//#define LV_MEM_POOL_INCLUDE your_alloc_library  /* Uncomment if using an external allocator*/
-//#define LV_MEM_POOL_ALLOC   your_alloc          /* Uncomment if using an external allocator*/
+#if LV_MEM_ADR == 0 && !defined(LVGL_MEM_INTERNAL)
+/*Widgets and styles only; the display draw buffers are allocated separately in internal RAM*/
+#define LV_MEM_POOL_INCLUDE <esp_heap_caps.h>
+#define LV_MEM_POOL_ALLOC(size) heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
 #endif
 
 #else       /*LV_MEM_CUSTOM*/
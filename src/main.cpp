@@ -23,6 +23,8 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "app.h"
+#include <signer_trace.h>
+#include "asset_store.h"
 
 // Import Nostr library for memory initialization
 #include "../lib/nostr/nostr.h"
@@ -32,12 +34,7 @@
 #define ENCRYPTED_MESSAGE_BIN_SIZE 100000
     
 
-// Remaining global variables that main.cpp still needs
-static unsigned long wifi_connect_start_time = 0;
-static const unsigned long WIFI_CONNECT_TIMEOUT = 10000; // 10 seconds
-static bool wifi_connection_attempted = false;
-
-// Legacy AP mode variables removed - now handled by WiFiManager module
+// Legacy AP mode and WiFi status polling removed - now handled by WiFiManager module
 
 // Queue definitions for task communication
 typedef enum {
@@ -71,9 +68,6 @@ static QueueHandle_t invoice_status_queue = NULL;
 // Global UI state variables (to be migrated to UI module eventually)
 static char current_ssid[33];
 static char current_password[65];
-static lv_obj_t *wifi_status_label = NULL;
-static lv_timer_t *wifi_status_timer = NULL;
-static lv_obj_t *main_wifi_status_label = NULL;
 static lv_obj_t *relay_status_label = NULL;
 
 // Invoice overlay variables (to be migrated to UI module eventually)
@@ -83,9 +77,6 @@ static int invoice_counter = 0;
 // Global state for preferences
 static Preferences preferences;
 
-// Forward declarations for functions that still need to be implemented or migrated
-static void wifi_main_status_updater_cb(lv_timer_t *timer);
-
 void setup(void)
 {
     Serial.begin(115200);
@@ -94,13 +85,16 @@ void setup(void)
     Serial.println("Initializing Nostr memory space...");
     nostr::initMemorySpace(EVENT_NOTE_SIZE, ENCRYPTED_MESSAGE_BIN_SIZE);
     Serial.println("Nostr memory space initialized");
+
+    // Cross-module event trace, dumped with the "trace" serial command
+    Trace::init(Trace::Config::DEFAULT_EVENTS);
+
+    // Web pages and other large read-only data, mapped from flash on demand
+    AssetStore::init();
     
     // Initialize all application modules through the App coordinator
     App::init();
     
-    // Create status update timer (this will eventually move to a module)
-    lv_timer_create(wifi_main_status_updater_cb, 1000, NULL);
-    
     // Create queues for task communication (this will eventually move to respective modules)
     wifi_command_queue = xQueueCreate(10, sizeof(wifi_command_t));
     wifi_scan_result_queue = xQueueCreate(5, sizeof(wifi_scan_result_t));
@@ -118,23 +112,3 @@ void loop(void)
     
     delay(5);
 }
-
-// Temporary status update function (will be moved to appropriate module)
-static void wifi_main_status_updater_cb(lv_timer_t *timer) {
-    // Check WiFi connection status and timeout
-    bool wifi_connected = (WiFi.status() == WL_CONNECTED);
-    
-    // If we attempted to connect but haven't succeeded within timeout, stop trying
-    if (wifi_connection_attempted && !wifi_connected) {
-        unsigned long current_time = millis();
-        if (current_time - wifi_connect_start_time > WIFI_CONNECT_TIMEOUT) {
-            Serial.println("WiFi connection timeout - stopping connection attempts");
-            WiFi.disconnect(true);
-            wifi_connection_attempted = false;
-        }
-    }
-    
-    // AP mode processing now handled by WiFiManager module
-    
-    delay(1);
-}
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include "metrics.h"
+#include "system_monitor.h"
+#include <esp_heap_caps.h>
+#include <lvgl.h>
+
+namespace Metrics {
+    typedef enum {
+        SERIES_COUNTER,
+        SERIES_GAUGE,
+        SERIES_SUMMARY
+    } series_type_t;
+
+    struct Series {
+        const char* name = nullptr;
+        series_type_t type = SERIES_COUNTER;
+        int32_t value = 0;      // Counter total or gauge value
+        uint32_t count = 0;     // Summary observations
+        uint64_t sum = 0;
+        uint32_t max = 0;
+    };
+
+    static Series series[Config::MAX_SERIES];
+    static int series_count = 0;
+    static portMUX_TYPE metrics_mux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Must be called with metrics_mux held
+    static Series* findOrCreate(const char* name, series_type_t type) {
+        for (int i = 0; i < series_count; i++) {
+            // Most callers pass the same literal every time
+            if (series[i].name == name || strcmp(series[i].name, name) == 0) {
+                return &series[i];
+            }
+        }
+        if (series_count >= Config::MAX_SERIES) {
+            return nullptr;
+        }
+        Series* entry = &series[series_count++];
+        entry->name = name;
+        entry->type = type;
+        return entry;
+    }
+
+    void increment(const char* name, uint32_t delta) {
+        portENTER_CRITICAL(&metrics_mux);
+        Series* entry = findOrCreate(name, SERIES_COUNTER);
+        if (entry) {
+            entry->value += delta;
+        }
+        portEXIT_CRITICAL(&metrics_mux);
+    }
+
+    void setGauge(const char* name, int32_t value) {
+        portENTER_CRITICAL(&metrics_mux);
+        Series* entry = findOrCreate(name, SERIES_GAUGE);
+        if (entry) {
+            entry->value = value;
+        }
+        portEXIT_CRITICAL(&metrics_mux);
+    }
+
+    // Must be called with metrics_mux held
+    static void addObservation(Series* entry, uint32_t value) {
+        entry->count++;
+        entry->sum += value;
+        if (value > entry->max) {
+            entry->max = value;
+        }
+    }
+
+    void observe(const char* name, uint32_t value) {
+        portENTER_CRITICAL(&metrics_mux);
+        Series* entry = findOrCreate(name, SERIES_SUMMARY);
+        if (entry) {
+            addObservation(entry, value);
+        }
+        portEXIT_CRITICAL(&metrics_mux);
+    }
+
+    // Series are never removed, so an index stays valid for the program's life
+    Handle summary(const char* name) {
+        Handle handle;
+        portENTER_CRITICAL(&metrics_mux);
+        Series* entry = findOrCreate(name, SERIES_SUMMARY);
+        if (entry) {
+            handle.index = entry - series;
+        }
+        portEXIT_CRITICAL(&metrics_mux);
+        return handle;
+    }
+
+    void observe(Handle handle, uint32_t value) {
+        if (handle.index < 0) {
+            return;
+        }
+        portENTER_CRITICAL(&metrics_mux);
+        addObservation(&series[handle.index], value);
+        portEXIT_CRITICAL(&metrics_mux);
+    }
+
+    uint32_t getCounter(const char* name) {
+        uint32_t value = 0;
+        portENTER_CRITICAL(&metrics_mux);
+        for (int i = 0; i < series_count; i++) {
+            if (strcmp(series[i].name, name) == 0) {
+                value = series[i].type == SERIES_SUMMARY ? series[i].count : (uint32_t)series[i].value;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&metrics_mux);
+        return value;
+    }
+
+    uint32_t getMax(const char* name) {
+        uint32_t value = 0;
+        portENTER_CRITICAL(&metrics_mux);
+        for (int i = 0; i < series_count; i++) {
+            if (strcmp(series[i].name, name) == 0) {
+                value = series[i].max;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&metrics_mux);
+        return value;
+    }
+
+    // HELP text per metric family; families not listed get their name
+    struct FamilyHelp {
+        const char* family;
+        const char* help;
+    };
+
+    static const FamilyHelp family_help[] = {
+        { "lvgl_render_duration_ms", "LVGL render time per refresh" },
+        { "lvgl_render_pixels", "Pixels flushed per refresh" },
+        { "signer_approval_wait_ms", "Time a request waited for on-screen approval" },
+        { "signer_authorized_clients", "Clients authorized to sign" },
+        { "signer_connect_rejected_total", "Connect requests without the bunker secret rejected on headless builds" },
+        { "signer_decrypt_duration_us", "NIP-04/NIP-44 request decryption time" },
+        { "signer_decrypt_failures_total", "Requests that failed to decrypt" },
+        { "signer_dns_cache_hits_total", "Relay lookups served from the DNS cache" },
+        { "signer_dns_failures_total", "Relay lookups that failed with nothing cached" },
+        { "signer_dns_rejected_responses_total", "DNS responses ignored for a wrong source, id or question" },
+        { "signer_dns_resolve_duration_ms", "Relay DNS query time" },
+        { "signer_dns_stale_served_total", "Relay lookups served from expired cache entries" },
+        { "signer_frame_bytes", "Size of received relay frames" },
+        { "signer_inflight_rejected_total", "Requests rejected because too many were in flight" },
+        { "signer_inflight_requests", "Requests awaiting a response" },
+        { "signer_inflight_timeouts_total", "In-flight requests that timed out" },
+        { "signer_loop_jitter_alerts_total", "Loop periods that deviated beyond the alert threshold" },
+        { "signer_loop_period_us", "Arduino loop period" },
+        { "signer_loopback_responses_total", "Responses to loopback load generator requests" },
+        { "signer_parse_failures_total", "Relay frames that failed to parse" },
+        { "signer_peer_answered_total", "Parked requests dropped after their owner's reply was seen" },
+        { "signer_peer_deferred_total", "Requests left to a peer signer" },
+        { "signer_peer_heartbeats_rejected_total", "Peer heartbeats rejected" },
+        { "signer_peer_replies_rejected_total", "Peer replies whose id or signature did not verify" },
+        { "signer_peer_takeovers_total", "Requests taken over from a silent peer" },
+        { "signer_publish_ok_total", "Write relay OK replies for device-published events" },
+        { "signer_publish_rejected_total", "Write relay rejections for device-published events" },
+        { "signer_publish_time_ms", "Time from signing until the first write relay has the event" },
+        { "signer_publish_timeouts_total", "Signed events never seen on a write relay" },
+        { "signer_publish_unsent_total", "Signed events not sent to any write relay" },
+        { "signer_rejected_total", "Requests rejected by the signer" },
+        { "signer_relay_address_fallbacks_total", "Relay addresses demoted after a failed connect" },
+        { "signer_relay_connected", "Whether the signer relay is connected" },
+        { "signer_relay_connects_total", "Signer relay connections established" },
+        { "signer_relay_disconnects_total", "Signer relay disconnections" },
+        { "signer_relay_handshake_duration_ms", "Time from the TCP connect, after the address lookup, until the WebSocket upgrade completed" },
+        { "signer_relay_inbound_dropped_total", "Inbound relay events dropped" },
+        { "signer_relay_inbound_wait_ms", "Time relay events waited in the inbound queue" },
+        { "signer_relay_loop_duration_us", "WebSocket client loop time on the network task" },
+        { "signer_relay_outbound_dropped_total", "Outbound relay frames dropped" },
+        { "signer_relay_plaintext_refused_total", "Plain ws:// connects refused because the address is not allow-listed" },
+        { "signer_relay_pin_check_us", "Relay certificate pin check time" },
+        { "signer_relay_pin_failures_total", "Relay certificates that did not match their pin" },
+        { "signer_relay_pin_session_hits_total", "Relay pin checks answered from the session table" },
+        { "signer_relay_pins_created_total", "Relay pins stored on first connect" },
+        { "signer_relay_resolve_duration_ms", "Relay address lookup time on the network task" },
+        { "signer_relay_rtt_ms", "Relay ping round-trip time" },
+        { "signer_relay_send_duration_us", "Time to write one frame to the relay" },
+        { "signer_request_age_s", "Age of requests when received" },
+        { "signer_request_duration_ms", "Request handling time" },
+        { "signer_requests_total", "Requests handled by method" },
+        { "signer_shed_total", "Stale requests dropped unanswered" },
+        { "signer_soak_block_drift", "Free heap block count change over the last soak" },
+        { "signer_soak_heap_drift_bytes", "Free heap change over the last soak" },
+        { "signer_soak_passed", "Whether the last soak finished without drift" },
+        { "ui_status_updates_skipped_total", "Status updates skipped as unchanged" },
+        { "ui_status_updates_total", "Status updates applied to the UI" },
+        { "ui_touch_latency_us", "Touch-to-photon latency by stage" },
+        { "ui_touch_traces_dropped_total", "Touch traces that never reached a redraw" },
+        { "wifi_link_loss_to_relay_disconnect_ms", "Time from WiFi link loss until the relay noticed" },
+        { "wifi_link_loss_to_relay_reconnect_ms", "Time from WiFi link loss until the relay reconnected" },
+        { "wifi_link_losses_total", "WiFi link losses" },
+        { "wifi_scan_duration_ms", "WiFi scan time" },
+    };
+
+    // Family name without the label set: foo{a="b"} -> foo
+    static String familyName(const char* name) {
+        const char* labelStart = strchr(name, '{');
+        return labelStart == nullptr ? String(name) : String(name).substring(0, labelStart - name);
+    }
+
+    // Label set without the braces, empty when there is none
+    static String labelSet(const char* name) {
+        const char* labelStart = strchr(name, '{');
+        if (labelStart == nullptr) {
+            return "";
+        }
+        String labels = labelStart + 1;
+        labels.remove(labels.length() - 1);
+        return labels;
+    }
+
+    static const char* familyHelp(const String& family) {
+        for (size_t i = 0; i < sizeof(family_help) / sizeof(family_help[0]); i++) {
+            if (family == family_help[i].family) {
+                return family_help[i].help;
+            }
+        }
+        return nullptr;
+    }
+
+    static void appendHeader(String& out, const String& family, const char* type, const char* help) {
+        out += "# HELP " + family + " " + (help != nullptr ? String(help) : family) + "\n";
+        out += "# TYPE " + family + " " + type + "\n";
+    }
+
+    static void appendGauge(String& out, const char* family, const char* help, uint32_t value) {
+        appendHeader(out, family, "gauge", help);
+        out += String(family) + " " + String(value) + "\n";
+    }
+
+    String render() {
+        Series snapshot[Config::MAX_SERIES];
+        int count;
+
+        portENTER_CRITICAL(&metrics_mux);
+        count = series_count;
+        for (int i = 0; i < count; i++) {
+            snapshot[i] = series[i];
+        }
+        portEXIT_CRITICAL(&metrics_mux);
+
+        String out;
+        out.reserve(8192);
+        appendGauge(out, "signer_uptime_seconds", "Seconds since boot", millis() / 1000);
+        appendGauge(out, "signer_heap_free_bytes", "Free internal heap", ESP.getFreeHeap());
+        appendGauge(out, "signer_heap_min_free_bytes", "Lowest free internal heap since boot", ESP.getMinFreeHeap());
+        appendGauge(out, "signer_psram_free_bytes", "Free PSRAM", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+
+        lv_mem_monitor_t lvgl_mem;
+        lv_mem_monitor(&lvgl_mem);
+        appendGauge(out, "lvgl_mem_total_bytes", "LVGL heap size", lvgl_mem.total_size);
+        appendGauge(out, "lvgl_mem_free_bytes", "Free LVGL heap", lvgl_mem.free_size);
+        appendGauge(out, "lvgl_mem_max_used_bytes", "Peak LVGL heap use", lvgl_mem.max_used);
+        appendGauge(out, "lvgl_mem_largest_free_bytes", "Largest free LVGL heap block", lvgl_mem.free_biggest_size);
+        appendGauge(out, "lvgl_mem_fragmentation_percent", "LVGL heap fragmentation", lvgl_mem.frag_pct);
+
+        // Series of one family must be contiguous under a single HELP/TYPE pair
+        bool written[Config::MAX_SERIES] = {};
+        for (int i = 0; i < count; i++) {
+            if (written[i]) {
+                continue;
+            }
+            String family = familyName(snapshot[i].name);
+            series_type_t type = snapshot[i].type;
+            appendHeader(out, family, type == SERIES_SUMMARY ? "summary" : (type == SERIES_GAUGE ? "gauge" : "counter"), familyHelp(family));
+
+            for (int j = i; j < count; j++) {
+                const Series& entry = snapshot[j];
+                if (written[j] || entry.type != type || familyName(entry.name) != family) {
+                    continue;
+                }
+                written[j] = true;
+                String labels = labelSet(entry.name);
+                String braced = labels.length() > 0 ? "{" + labels + "}" : "";
+                if (type == SERIES_SUMMARY) {
+                    // The maximum since boot is the 1.0 quantile
+                    out += family + "{" + labels + (labels.length() > 0 ? "," : "") + "quantile=\"1\"} " + String(entry.max) + "\n";
+                    out += family + "_sum" + braced + " " + String((unsigned long long)entry.sum) + "\n";
+                    out += family + "_count" + braced + " " + String(entry.count) + "\n";
+                } else if (type == SERIES_GAUGE) {
+                    out += family + braced + " " + String(entry.value) + "\n";
+                } else {
+                    out += family + braced + " " + String((uint32_t)entry.value) + "\n";
+                }
+            }
+        }
+        out += SystemMonitor::renderMetrics();
+        return out;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Process-wide counters, gauges and timing summaries.
+ *
+ * Series are identified by their full Prometheus name including labels,
+ * e.g. `signer_requests_total{method="ping"}`. Names must be string
+ * literals or otherwise outlive the program; they are stored by pointer.
+ */
+namespace Metrics {
+    void increment(const char* name, uint32_t delta = 1);
+    void setGauge(const char* name, int32_t value);
+    void observe(const char* name, uint32_t value);
+
+    // Resolved once for hot paths (every loop pass or socket poll), so
+    // observing skips the name lookup. Invalid when the table is full.
+    struct Handle {
+        int index = -1;
+    };
+    Handle summary(const char* name);
+    void observe(Handle handle, uint32_t value);
+
+    // Lookups for on-device diagnostics
+    uint32_t getCounter(const char* name);
+    uint32_t getMax(const char* name);
+
+    // Prometheus text exposition format
+    String render();
+
+    namespace Config {
+        const int MAX_SERIES = 96;
+    }
+}
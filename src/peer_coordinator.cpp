@@ -0,0 +1,405 @@
+#include "peer_coordinator.h"
+#include <Preferences.h>
+#include <ArduinoJson.h>
+#include "metrics.h"
+
+#include "../lib/nostr/nostr.h"
+
+namespace PeerCoordinator {
+    struct PeerEntry {
+        String instanceId;
+        String clientTags;              // "|tag|tag|" of the clients it has authorized
+        unsigned long lastSeen = 0;
+        bool active = false;
+    };
+
+    struct DeferredRequest {
+        String eventId;
+        String rawMessage;
+        String ownerId;
+        String clientTag;
+        bool authorizedHere = false;
+        unsigned long receivedAt = 0;
+        bool reassigned = false;
+        bool active = false;
+    };
+
+    static bool peer_mode_enabled = false;
+    static String instance_id = "";
+    static PeerEntry peers[Config::MAX_PEERS];
+    static DeferredRequest deferred[Config::MAX_DEFERRED_REQUESTS];
+    static unsigned long last_heartbeat_sent = 0;
+    static unsigned long takeover_count = 0;
+
+    void init() {
+        Preferences prefs;
+        prefs.begin("signer", true); // Read-only
+        peer_mode_enabled = prefs.getBool("peer_mode", false);
+        instance_id = prefs.getString("instance_id", "");
+        prefs.end();
+
+        // Instance ids only need to be unique among peers, not secret
+        if (instance_id.length() != 16) {
+            instance_id = "";
+            for (int i = 0; i < 16; i++) {
+                instance_id += "0123456789abcdef"[esp_random() % 16];
+            }
+
+            Preferences writePrefs;
+            if (writePrefs.begin("signer", false)) {
+                writePrefs.putString("instance_id", instance_id);
+                writePrefs.end();
+            }
+        }
+
+        Serial.println("PeerCoordinator::init() - Instance " + instance_id + ", peer mode " + String(peer_mode_enabled ? "enabled" : "disabled"));
+    }
+
+    bool isEnabled() {
+        return peer_mode_enabled;
+    }
+
+    void setEnabled(bool enabled) {
+        peer_mode_enabled = enabled;
+
+        Preferences prefs;
+        if (prefs.begin("signer", false)) {
+            prefs.putBool("peer_mode", enabled);
+            prefs.end();
+        }
+        Serial.println("PeerCoordinator::setEnabled() - Peer mode " + String(enabled ? "enabled" : "disabled"));
+    }
+
+    String getInstanceId() {
+        return instance_id;
+    }
+
+    bool isHeartbeatDue() {
+        return peer_mode_enabled && (last_heartbeat_sent == 0 || millis() - last_heartbeat_sent >= Config::HEARTBEAT_INTERVAL);
+    }
+
+    // Heartbeats, and the replies peers send, which name the request they answer
+    String buildSubscription(const String& devicePublicKeyHex) {
+        return "[\"REQ\", \"" + String(Config::SUBSCRIPTION_ID) + "\", {\"kinds\":[" + String(Config::HEARTBEAT_KIND) + "," + String(Config::REPLY_KIND) + "], \"authors\":[\"" + devicePublicKeyHex + "\"], \"limit\":0}]";
+    }
+
+    // Keyed with the device key so relays cannot tell which clients use the bunker
+    String clientTag(const String& devicePrivateKeyHex, const String& clientPubKey) {
+        byte hash[32] = {0};
+        sha256(devicePrivateKeyHex + ":" + clientPubKey, hash);
+        return toHex(hash, Config::CLIENT_TAG_BYTES);
+    }
+
+    String buildHeartbeat(const String& devicePrivateKeyHex, const String& devicePublicKeyHex, unsigned long timestamp, const String& authorizedClients) {
+        last_heartbeat_sent = millis();
+
+        String clients = "";
+        int start = 0;
+        while (start < (int)authorizedClients.length()) {
+            int end = authorizedClients.indexOf('|', start);
+            if (end == -1) {
+                end = authorizedClients.length();
+            }
+            if (end > start) {
+                clients += (clients.length() > 0 ? ",\"" : "\"") + clientTag(devicePrivateKeyHex, authorizedClients.substring(start, end)) + "\"";
+            }
+            start = end + 1;
+        }
+
+        String content = "{\"instance\":\"" + instance_id + "\",\"peers\":" + String(getLivePeerCount()) + ",\"clients\":[" + clients + "]}";
+        String tags = "[[\"expiration\",\"" + String(timestamp + Config::PEER_DEADLINE / 1000) + "\"]]";
+        String note = nostr::getNote(
+            devicePrivateKeyHex.c_str(),
+            devicePublicKeyHex.c_str(),
+            timestamp,
+            content,
+            Config::HEARTBEAT_KIND,
+            tags);
+
+        return "[\"EVENT\"," + note + "]";
+    }
+
+    static unsigned int skipWhitespace(const String& message, unsigned int index) {
+        while (index < message.length() && isspace((unsigned char)message.charAt(index))) {
+            index++;
+        }
+        return index;
+    }
+
+    // ["EVENT", "<subscription id>", {...}] with the id equal to ours
+    bool isPeerMessage(const String& message) {
+        if (!message.startsWith("[\"EVENT\"")) {
+            return false;
+        }
+        unsigned int index = skipWhitespace(message, 8);
+        if (index >= message.length() || message.charAt(index) != ',') {
+            return false;
+        }
+        index = skipWhitespace(message, index + 1);
+        if (index >= message.length() || message.charAt(index) != '"') {
+            return false;
+        }
+        int end = message.indexOf('"', index + 1);
+        if (end == -1) {
+            return false;
+        }
+        return message.substring(index + 1, end) == Config::SUBSCRIPTION_ID;
+    }
+
+    // A peer answered a request: drop the parked copy so it is never answered twice
+    static void handleReply(const String& message, const String& replyTo) {
+        for (int i = 0; i < Config::MAX_DEFERRED_REQUESTS; i++) {
+            DeferredRequest& request = deferred[i];
+            if (!request.active || request.eventId != replyTo) {
+                continue;
+            }
+
+            // Checked only on a match: replies can be large, and a forged one
+            // must not be able to suppress a takeover
+            DynamicJsonDocument doc(message.length() + Config::REPLY_PARSE_OVERHEAD);
+            if (deserializeJson(doc, message) || !nostr::verifyEvent(doc[2].as<JsonObjectConst>())) {
+                Serial.println("PeerCoordinator::handleReply() - Rejected reply with a bad id or signature");
+                Metrics::increment("signer_peer_replies_rejected_total");
+                return;
+            }
+
+            request.active = false;
+            request.rawMessage = "";
+            Metrics::increment("signer_peer_answered_total");
+            Serial.println("PeerCoordinator::handleReply() - Request " + replyTo.substring(0, 8) + " answered by its owner");
+            return;
+        }
+    }
+
+    void handlePeerMessage(const String& message, const String& devicePublicKeyHex, unsigned long unixTimestamp) {
+        // Routing fields only; replies carry whole signed events in their content
+        StaticJsonDocument<128> filter;
+        filter[2]["pubkey"] = true;
+        filter[2]["kind"] = true;
+        filter[2]["tags"] = true;
+        DynamicJsonDocument header(1024);
+        if (deserializeJson(header, message, DeserializationOption::Filter(filter))) {
+            return;
+        }
+        JsonObjectConst headerEvent = header[2].as<JsonObjectConst>();
+        if (headerEvent["pubkey"].as<String>() != devicePublicKeyHex) {
+            return;
+        }
+        if (headerEvent["kind"] == Config::REPLY_KIND) {
+            for (JsonArrayConst tag : headerEvent["tags"].as<JsonArrayConst>()) {
+                if (tag[0] == "e") {
+                    handleReply(message, tag[1].as<String>());
+                    break;
+                }
+            }
+            return;
+        }
+        if (headerEvent["kind"] != Config::HEARTBEAT_KIND) {
+            return;
+        }
+
+        DynamicJsonDocument doc(3072);
+        DeserializationError error = deserializeJson(doc, message);
+        if (error) {
+            Serial.println("PeerCoordinator::handlePeerMessage() - JSON parsing failed: " + String(error.c_str()));
+            return;
+        }
+        JsonObjectConst event = doc[2].as<JsonObjectConst>();
+
+        // Only holders of the device key may join; relays are not trusted to check
+        if (!nostr::verifyEvent(event)) {
+            Serial.println("PeerCoordinator::handlePeerMessage() - Rejected heartbeat with a bad id or signature");
+            Metrics::increment("signer_peer_heartbeats_rejected_total{reason=\"signature\"}");
+            return;
+        }
+
+        // A replayed heartbeat must not bring back a peer that has gone
+        unsigned long createdAt = event["created_at"];
+        if (unixTimestamp > 0 && createdAt + Config::PEER_DEADLINE / 1000 < unixTimestamp) {
+            Metrics::increment("signer_peer_heartbeats_rejected_total{reason=\"stale\"}");
+            return;
+        }
+
+        DynamicJsonDocument contentDoc(Config::HEARTBEAT_CONTENT_SIZE);
+        if (deserializeJson(contentDoc, event["content"].as<String>())) {
+            return;
+        }
+
+        String peerId = contentDoc["instance"].as<String>();
+        if (peerId.length() == 0 || peerId == instance_id) {
+            return;
+        }
+
+        // Replaced on every heartbeat, so removals on the peer are picked up too
+        String clientTags = "|";
+        for (JsonVariantConst tag : contentDoc["clients"].as<JsonArrayConst>()) {
+            clientTags += tag.as<String>() + "|";
+        }
+
+        unsigned long now = millis();
+        int freeSlot = -1;
+        int oldestSlot = 0;
+        for (int i = 0; i < Config::MAX_PEERS; i++) {
+            if (peers[i].active && peers[i].instanceId == peerId) {
+                peers[i].lastSeen = now;
+                peers[i].clientTags = clientTags;
+                return;
+            }
+            if (!peers[i].active && freeSlot == -1) {
+                freeSlot = i;
+            }
+            if (peers[i].lastSeen < peers[oldestSlot].lastSeen) {
+                oldestSlot = i;
+            }
+        }
+
+        int slot = freeSlot != -1 ? freeSlot : oldestSlot;
+        peers[slot].instanceId = peerId;
+        peers[slot].clientTags = clientTags;
+        peers[slot].lastSeen = now;
+        peers[slot].active = true;
+        Serial.println("PeerCoordinator::handlePeerMessage() - Peer joined: " + peerId + " (live peers: " + String(getLivePeerCount()) + ")");
+    }
+
+    int getLivePeerCount() {
+        int count = 0;
+        for (int i = 0; i < Config::MAX_PEERS; i++) {
+            if (peers[i].active) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // Rendezvous (highest random weight) hashing: every peer ranks the same
+    // live set the same way, and losing a peer only moves that peer's share.
+    static uint32_t rendezvousScore(const String& eventId, const String& instanceId) {
+        byte hash[32] = {0};
+        sha256(eventId + instanceId, hash);
+        return ((uint32_t)hash[0] << 24) | ((uint32_t)hash[1] << 16) | ((uint32_t)hash[2] << 8) | (uint32_t)hash[3];
+    }
+
+    static bool hasAuthorized(const PeerEntry& peer, const String& clientTag) {
+        return clientTag.length() > 0 && peer.clientTags.indexOf("|" + clientTag + "|") != -1;
+    }
+
+    // Only signers paired with the client can answer it; while none is,
+    // the request is a pairing attempt and any signer may take it
+    static String ownerOf(const String& eventId, const String& clientTag, bool authorizedHere) {
+        bool anyAuthorized = authorizedHere;
+        for (int i = 0; i < Config::MAX_PEERS && !anyAuthorized; i++) {
+            anyAuthorized = peers[i].active && hasAuthorized(peers[i], clientTag);
+        }
+
+        String owner = "";
+        uint32_t bestScore = 0;
+        if (authorizedHere || !anyAuthorized) {
+            owner = instance_id;
+            bestScore = rendezvousScore(eventId, instance_id);
+        }
+
+        for (int i = 0; i < Config::MAX_PEERS; i++) {
+            if (!peers[i].active || (anyAuthorized && !hasAuthorized(peers[i], clientTag))) {
+                continue;
+            }
+            uint32_t score = rendezvousScore(eventId, peers[i].instanceId);
+            if (owner.length() == 0 || score > bestScore || (score == bestScore && peers[i].instanceId < owner)) {
+                bestScore = score;
+                owner = peers[i].instanceId;
+            }
+        }
+        return owner;
+    }
+
+    static bool isPeerLive(const String& peerId) {
+        for (int i = 0; i < Config::MAX_PEERS; i++) {
+            if (peers[i].active && peers[i].instanceId == peerId) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isOwner(const String& eventId, const String& clientTag, bool authorizedHere) {
+        if (!peer_mode_enabled || eventId.length() == 0) {
+            return true;
+        }
+        return ownerOf(eventId, clientTag, authorizedHere) == instance_id;
+    }
+
+    void deferRequest(const String& eventId, const String& rawMessage, const String& clientTag, bool authorizedHere) {
+        int slot = 0;
+        for (int i = 0; i < Config::MAX_DEFERRED_REQUESTS; i++) {
+            if (!deferred[i].active) {
+                slot = i;
+                break;
+            }
+            if (deferred[i].receivedAt < deferred[slot].receivedAt) {
+                slot = i;
+            }
+        }
+
+        deferred[slot].eventId = eventId;
+        deferred[slot].rawMessage = rawMessage;
+        deferred[slot].clientTag = clientTag;
+        deferred[slot].authorizedHere = authorizedHere;
+        deferred[slot].ownerId = ownerOf(eventId, clientTag, authorizedHere);
+        deferred[slot].receivedAt = millis();
+        deferred[slot].reassigned = false;
+        deferred[slot].active = true;
+
+        Serial.println("PeerCoordinator::deferRequest() - Request " + eventId.substring(0, 8) + " owned by peer " + deferred[slot].ownerId);
+    }
+
+    void pruneExpired() {
+        unsigned long now = millis();
+
+        for (int i = 0; i < Config::MAX_PEERS; i++) {
+            if (peers[i].active && now - peers[i].lastSeen > Config::PEER_DEADLINE) {
+                Serial.println("PeerCoordinator::pruneExpired() - Peer missed its deadline: " + peers[i].instanceId);
+                peers[i].active = false;
+            }
+        }
+
+        for (int i = 0; i < Config::MAX_DEFERRED_REQUESTS; i++) {
+            DeferredRequest& request = deferred[i];
+            if (!request.active || request.reassigned) {
+                continue;
+            }
+
+            // A live owner is assumed to have answered by now
+            if (now - request.receivedAt > Config::DEFERRED_REQUEST_TTL) {
+                request.active = false;
+                request.rawMessage = "";
+                continue;
+            }
+
+            if (isPeerLive(request.ownerId)) {
+                continue;
+            }
+
+            request.ownerId = ownerOf(request.eventId, request.clientTag, request.authorizedHere);
+            if (request.ownerId == instance_id) {
+                request.reassigned = true;
+                takeover_count++;
+                Serial.println("PeerCoordinator::pruneExpired() - Taking over request " + request.eventId.substring(0, 8));
+            }
+        }
+    }
+
+    bool takeReassignedRequest(String& rawMessage) {
+        for (int i = 0; i < Config::MAX_DEFERRED_REQUESTS; i++) {
+            if (deferred[i].active && deferred[i].reassigned) {
+                rawMessage = deferred[i].rawMessage;
+                deferred[i].rawMessage = "";
+                deferred[i].active = false;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    unsigned long getTakeoverCount() {
+        return takeover_count;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Coordinates several signers sharing the same device and user keys.
+ *
+ * Peers announce themselves with ephemeral heartbeat events signed by the
+ * shared device key. Each heartbeat lists keyed tags of the clients its
+ * sender has authorized, since pairings live in each device's own NVS.
+ * Every peer sees every request on the relay, so each one independently
+ * computes the owner of a request by rendezvous hashing the event id
+ * against the live instance ids that have authorized the sender (all of
+ * them while nobody has, so pairing still works). Only the owner answers;
+ * the others park the request until they see the owner's reply (tagged
+ * with the request's event id) and take it over if the owner misses its
+ * heartbeat deadline before answering.
+ */
+namespace PeerCoordinator {
+    // Initialization
+    void init();
+
+    // Configuration
+    bool isEnabled();
+    void setEnabled(bool enabled);
+    String getInstanceId();
+
+    // Heartbeats
+    bool isHeartbeatDue();
+    String buildSubscription(const String& devicePublicKeyHex);
+    // authorizedClients is the '|'-separated list of clients paired with this device
+    String buildHeartbeat(const String& devicePrivateKeyHex, const String& devicePublicKeyHex, unsigned long timestamp, const String& authorizedClients);
+    bool isPeerMessage(const String& message);
+    // Heartbeats and peer replies; unixTimestamp is the current time, 0 while
+    // the clock is not synced
+    void handlePeerMessage(const String& message, const String& devicePublicKeyHex, unsigned long unixTimestamp);
+    int getLivePeerCount();
+
+    // Request ownership; clientTag comes from clientTag() for the request's
+    // sender, authorizedHere tells whether this device has paired with it
+    String clientTag(const String& devicePrivateKeyHex, const String& clientPubKey);
+    bool isOwner(const String& eventId, const String& clientTag, bool authorizedHere);
+    void deferRequest(const String& eventId, const String& rawMessage, const String& clientTag, bool authorizedHere);
+    void pruneExpired();
+    bool takeReassignedRequest(String& rawMessage);
+    unsigned long getTakeoverCount();
+
+    // Constants
+    namespace Config {
+        const char* const SUBSCRIPTION_ID = "peers";
+        const uint16_t HEARTBEAT_KIND = 24134;
+        const uint16_t REPLY_KIND = 24133;
+        const size_t REPLY_PARSE_OVERHEAD = 2048;
+        const unsigned long HEARTBEAT_INTERVAL = 5000;
+        const unsigned long PEER_DEADLINE = 15000;
+        const unsigned long DEFERRED_REQUEST_TTL = 30000;
+        const int MAX_PEERS = 8;
+        const int MAX_DEFERRED_REQUESTS = 8;
+        const int CLIENT_TAG_BYTES = 4;
+        const size_t HEARTBEAT_CONTENT_SIZE = 1536;    // Room for 30 client tags
+    }
+}
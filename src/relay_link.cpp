@@ -0,0 +1,345 @@
+#include "relay_link.h"
+#include "wifi_manager.h"
+#include "metrics.h"
+#include "cert_pins.h"
+#include "dns_cache.h"
+#include "relay_url.h"
+#include <esp_heap_caps.h>
+#include <signer_trace.h>
+
+namespace RelayLink {
+    typedef enum {
+        COMMAND_CONNECT,
+        COMMAND_DISCONNECT,
+        COMMAND_NEXT_ADDRESS,
+        COMMAND_SEND_TEXT,
+        COMMAND_SEND_PING
+    } command_type_t;
+
+    struct Command {
+        command_type_t type;
+        char* text;                 // COMMAND_SEND_TEXT, owned by the command
+        size_t length;
+        ConnectParams* connect;     // COMMAND_CONNECT, owned by the command
+    };
+
+    // Only touched on the network task
+    static WebSocketsClient webSocket;
+    static bool relay_secure = true;
+    static String relay_host = "";
+    static bool relay_use_cache = false;
+    static IPAddress relay_address;
+    static bool relay_have_address = false;
+    static String relay_allow_list = "";
+    static bool relay_refused = false;      // Plain ws:// address not allow-listed; the client is not polled
+
+    static TaskHandle_t link_task_handle = NULL;
+    static QueueHandle_t command_queue = NULL;
+    static QueueHandle_t inbound_queue = NULL;
+    static volatile bool link_connected = false;
+    static volatile bool link_stopping = false;
+    static TaskHandle_t cleanup_waiter = NULL;
+
+    // Observed on every send and socket poll; resolved when the task starts
+    static Metrics::Handle send_duration_ws;
+    static Metrics::Handle send_duration_wss;
+    static Metrics::Handle loop_duration_ws;
+    static Metrics::Handle loop_duration_wss;
+
+    static uint8_t* copyPayload(const uint8_t* payload, size_t length) {
+        uint8_t* copy = (uint8_t*)heap_caps_malloc(length + 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (copy == nullptr) {
+            return nullptr;
+        }
+        if (payload != nullptr && length > 0) {
+            memcpy(copy, payload, length);
+        }
+        copy[length] = '\0';
+        return copy;
+    }
+
+    // Points the client at the host's first cached address, or lets the
+    // library resolve the name itself when the lookup fails
+    static void useCachedAddress() {
+        IPAddress addresses[DnsCache::Config::MAX_ADDRESSES];
+        unsigned long resolveStart = millis();
+        int count = DnsCache::resolve(relay_host, addresses, DnsCache::Config::MAX_ADDRESSES);
+        Metrics::observe("signer_relay_resolve_duration_ms", millis() - resolveStart);
+
+        relay_have_address = count > 0;
+        if (relay_have_address) {
+            relay_address = addresses[0];
+            webSocket.setConnectAddress(relay_address);
+        } else {
+            webSocket.clearConnectAddress();
+        }
+    }
+
+    // Client callback, runs on the network task
+    static void queueEvent(WStype_t type, uint8_t* payload, size_t length) {
+        if (type == WStype_CONNECTED && relay_have_address) {
+            DnsCache::markGood(relay_host, relay_address);
+        }
+
+        bool isFrame = type == WStype_TEXT || type == WStype_BIN;
+        if (!isFrame && type != WStype_CONNECTED && type != WStype_DISCONNECTED && type != WStype_PONG && type != WStype_PING && type != WStype_ERROR) {
+            return;
+        }
+
+        // Only connection state changes may take the reserved slots; frames,
+        // pings, pongs and errors are dropped once the rest is full
+        bool isStateChange = type == WStype_CONNECTED || type == WStype_DISCONNECTED;
+        if (!isStateChange && (int)uxQueueSpacesAvailable(inbound_queue) <= Config::INBOUND_RESERVED_SLOTS) {
+            Metrics::increment("signer_relay_inbound_dropped_total");
+            return;
+        }
+
+        Event event;
+        event.type = type;
+        event.length = length;
+        event.received = millis();
+        event.connectStarted = type == WStype_CONNECTED ? webSocket.getConnectStarted() : 0;
+        event.payload = nullptr;
+        if (length <= Config::MAX_FRAME_SIZE) {
+            event.payload = copyPayload(payload, length);
+            if (event.payload == nullptr) {
+                Serial.println("RelayLink::queueEvent() - No memory for a " + String(length) + " byte frame");
+                Metrics::increment("signer_relay_inbound_dropped_total");
+                return;
+            }
+        }
+
+        if (xQueueSend(inbound_queue, &event, 0) != pdTRUE) {
+            free(event.payload);
+            Metrics::increment("signer_relay_inbound_dropped_total");
+        }
+    }
+
+    // Plain ws:// must land on an allow-listed address, not just an
+    // allow-listed name, or a spoofed lookup could send it off the LAN
+    static void checkPlaintextAddress() {
+        relay_refused = !relay_secure && (!relay_have_address || !RelayUrl::isPlaintextAllowed(relay_address.toString(), relay_allow_list));
+        if (!relay_refused) {
+            return;
+        }
+        Serial.println("RelayLink::checkPlaintextAddress() - Refusing ws:// to " + relay_host + (relay_have_address ? " at " + relay_address.toString() : String(" without a resolved address")) + ", not on the allow-list");
+        Metrics::increment("signer_relay_plaintext_refused_total");
+        webSocket.disconnect();
+        // Lets the signer try the next address or schedule a reconnect
+        queueEvent(WStype_DISCONNECTED, nullptr, 0);
+    }
+
+    static void applyConnect(const ConnectParams& params) {
+        relay_secure = params.secure;
+        if (params.secure) {
+#ifdef RELAY_CA_BUNDLE
+            if (params.useCaBundle) {
+#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3, 0, 4)
+                webSocket.beginSslWithBundle(params.host.c_str(), params.port, params.path.c_str(), relay_ca_bundle_start, relay_ca_bundle_end - relay_ca_bundle_start);
+#else
+                webSocket.beginSslWithBundle(params.host.c_str(), params.port, params.path.c_str(), relay_ca_bundle_start);
+#endif
+            } else
+#endif
+            {
+                webSocket.beginSSL(params.host.c_str(), params.port, params.path.c_str());
+            }
+        } else {
+            webSocket.begin(params.host.c_str(), params.port, params.path.c_str());
+        }
+
+        // Pin mode checks the leaf key hash right after the handshake
+        if (params.secure && params.pinHostPort.length() > 0) {
+            String hostPort = params.pinHostPort;
+            webSocket.setPeerCertVerifier([hostPort](const mbedtls_x509_crt *cert) {
+                return CertPins::verifyPeer(hostPort, cert);
+            });
+        } else {
+            webSocket.setPeerCertVerifier(nullptr);
+        }
+
+        relay_host = params.host;
+        relay_use_cache = params.useDnsCache;
+        relay_allow_list = params.plaintextAllowList;
+        relay_have_address = false;
+        if (relay_use_cache) {
+            useCachedAddress();
+        } else {
+            webSocket.clearConnectAddress();
+        }
+        checkPlaintextAddress();
+        webSocket.onEvent(queueEvent);
+        webSocket.setReconnectInterval(params.reconnectInterval);
+    }
+
+    static void applyCommand(Command& command) {
+        switch (command.type) {
+            case COMMAND_CONNECT:
+                applyConnect(*command.connect);
+                delete command.connect;
+                break;
+            case COMMAND_DISCONNECT:
+                webSocket.disconnect();
+                break;
+            case COMMAND_NEXT_ADDRESS:
+                if (relay_use_cache) {
+                    if (relay_have_address) {
+                        DnsCache::demote(relay_host, relay_address);
+                    }
+                    useCachedAddress();
+                    checkPlaintextAddress();
+                }
+                break;
+            case COMMAND_SEND_TEXT: {
+                TRACE_SCOPE("relay_link_send");
+                unsigned long sendStart = micros();
+                webSocket.sendTXT(command.text, command.length);
+                Metrics::observe(relay_secure ? send_duration_wss : send_duration_ws, micros() - sendStart);
+                free(command.text);
+                break;
+            }
+            case COMMAND_SEND_PING:
+                webSocket.sendPing();
+                break;
+        }
+    }
+
+    static void linkTask(void* parameter) {
+        Serial.println("RelayLink::linkTask() - Network task started on core " + String(xPortGetCoreID()));
+        send_duration_ws = Metrics::summary("signer_relay_send_duration_us{transport=\"ws\"}");
+        send_duration_wss = Metrics::summary("signer_relay_send_duration_us{transport=\"wss\"}");
+        loop_duration_ws = Metrics::summary("signer_relay_loop_duration_us{transport=\"ws\"}");
+        loop_duration_wss = Metrics::summary("signer_relay_loop_duration_us{transport=\"wss\"}");
+        while (!link_stopping) {
+            // Wake as soon as something is queued; otherwise poll the socket
+            Command command;
+            if (xQueueReceive(command_queue, &command, pdMS_TO_TICKS(Config::POLL_INTERVAL_MS)) == pdTRUE) {
+                do {
+                    applyCommand(command);
+                } while (xQueueReceive(command_queue, &command, 0) == pdTRUE);
+            }
+
+            if (!relay_refused && WiFiManager::isConnected() && !WiFiManager::isBackgroundOperationsPaused()) {
+                // Includes TLS record decryption on wss://
+                unsigned long loopStart = micros();
+                webSocket.loop();
+                Metrics::observe(relay_secure ? loop_duration_wss : loop_duration_ws, micros() - loopStart);
+            }
+            link_connected = webSocket.isConnected();
+        }
+
+        // Stopped by cleanup(); close the socket from the task that owns it
+        webSocket.disconnect();
+        link_connected = false;
+        Serial.println("RelayLink::linkTask() - Network task stopped");
+        link_task_handle = NULL;
+        if (cleanup_waiter != NULL) {
+            xTaskNotifyGive(cleanup_waiter);
+        }
+        vTaskDelete(NULL);
+    }
+
+    void init() {
+        if (link_task_handle != NULL) {
+            return;
+        }
+        if (command_queue == NULL) {
+            command_queue = xQueueCreate(Config::COMMAND_QUEUE_LENGTH, sizeof(Command));
+        }
+        if (inbound_queue == NULL) {
+            inbound_queue = xQueueCreate(Config::INBOUND_QUEUE_LENGTH, sizeof(Event));
+        }
+        link_stopping = false;
+        xTaskCreatePinnedToCore(
+            linkTask,
+            "RelayLink",
+            Config::TASK_STACK_SIZE,
+            NULL,
+            Config::TASK_PRIORITY,
+            &link_task_handle,
+            Config::TASK_CORE
+        );
+    }
+
+    void cleanup() {
+        // The task may be inside the client loop or a TLS handshake, so it is
+        // asked to stop and exits at the top of its next iteration
+        if (link_task_handle != NULL) {
+            cleanup_waiter = xTaskGetCurrentTaskHandle();
+            link_stopping = true;
+            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(Config::TASK_STOP_TIMEOUT_MS)) == 0) {
+                Serial.println("RelayLink::cleanup() - Network task did not stop in time, leaving queues in place");
+                cleanup_waiter = NULL;
+                return;
+            }
+            cleanup_waiter = NULL;
+        }
+        link_connected = false;
+
+        Command command;
+        while (command_queue != NULL && xQueueReceive(command_queue, &command, 0) == pdTRUE) {
+            free(command.text);
+            delete command.connect;
+        }
+        Event event;
+        while (takeEvent(event)) {
+            releaseEvent(event);
+        }
+    }
+
+    static bool queueCommand(Command& command) {
+        if (command_queue == NULL || xQueueSend(command_queue, &command, 0) != pdTRUE) {
+            free(command.text);
+            delete command.connect;
+            return false;
+        }
+        return true;
+    }
+
+    bool connect(const ConnectParams& params) {
+        Command command = { COMMAND_CONNECT, nullptr, 0, new ConnectParams(params) };
+        return queueCommand(command);
+    }
+
+    bool disconnect() {
+        link_connected = false;
+        Command command = { COMMAND_DISCONNECT, nullptr, 0, nullptr };
+        return queueCommand(command);
+    }
+
+    bool tryNextAddress() {
+        Command command = { COMMAND_NEXT_ADDRESS, nullptr, 0, nullptr };
+        return queueCommand(command);
+    }
+
+    bool sendText(const String& text) {
+        char* copy = (char*)copyPayload((const uint8_t*)text.c_str(), text.length());
+        if (copy == nullptr) {
+            return false;
+        }
+        Command command = { COMMAND_SEND_TEXT, copy, text.length(), nullptr };
+        return queueCommand(command);
+    }
+
+    bool hasSendSpace() {
+        return command_queue != NULL && uxQueueSpacesAvailable(command_queue) > 0;
+    }
+
+    bool sendPing() {
+        Command command = { COMMAND_SEND_PING, nullptr, 0, nullptr };
+        return queueCommand(command);
+    }
+
+    bool takeEvent(Event& event) {
+        return inbound_queue != NULL && xQueueReceive(inbound_queue, &event, 0) == pdTRUE;
+    }
+
+    void releaseEvent(Event& event) {
+        free(event.payload);
+        event.payload = nullptr;
+    }
+
+    bool isConnected() {
+        return link_connected;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebSocketsClient.h>
+
+/**
+ * Relay WebSocket owned by a network task on the WiFi core.
+ *
+ * The task runs the client loop (socket reads, TLS, automatic pong
+ * replies) independently of LVGL work on the Arduino loop task. Frames and
+ * connection events are copied into an inbound queue that the signer
+ * drains with takeEvent(). Everything that touches the client from outside
+ * the task (connect, disconnect, sends) is queued as a command and applied
+ * by the task in order.
+ */
+namespace RelayLink {
+    struct Event {
+        WStype_t type;
+        uint8_t* payload;     // NUL-terminated copy, nullptr when dropped for size
+        size_t length;
+        unsigned long received;
+        unsigned long connectStarted;   // WStype_CONNECTED: when the TCP connect began, after the lookup
+    };
+
+    struct ConnectParams {
+        String host;
+        uint16_t port = 443;
+        String path = "/";
+        bool secure = true;
+        bool useCaBundle = false;   // Chain validation against the linked bundle
+        String pinHostPort;         // Verify the peer against CertPins when set
+        bool useDnsCache = false;   // Resolve host through DnsCache on the network task
+        String plaintextAllowList;  // ws:// only connects to addresses on this list (needs useDnsCache)
+        unsigned long reconnectInterval = 5000;
+    };
+
+    void init();
+    void cleanup();
+
+    // Commands, applied by the network task in the order they were queued
+    bool connect(const ConnectParams& params);
+    bool disconnect();
+    // Moves the address that just failed behind the host's other addresses
+    // and connects to the next one
+    bool tryNextAddress();
+    // False when the frame could not be queued; nothing is counted here, the
+    // caller records signer_relay_outbound_dropped_total if it gives up on it
+    bool sendText(const String& text);
+    // False while the command queue is full, so callers can retry later
+    bool hasSendSpace();
+    bool sendPing();
+
+    // Inbound events; each taken event must be handed back with releaseEvent()
+    bool takeEvent(Event& event);
+    void releaseEvent(Event& event);
+
+    bool isConnected();
+
+    namespace Config {
+        const uint32_t TASK_STACK_SIZE = 8192;     // TLS handshakes run on this task
+        const UBaseType_t TASK_PRIORITY = 2;        // Above the WiFi scan task
+        const BaseType_t TASK_CORE = 0;             // WiFi core; LVGL runs on core 1
+        const uint32_t POLL_INTERVAL_MS = 2;
+        const uint32_t TASK_STOP_TIMEOUT_MS = 10000; // Covers a TLS handshake in progress
+        const int INBOUND_QUEUE_LENGTH = 16;
+        const int INBOUND_RESERVED_SLOTS = 2;       // Kept free for CONNECTED/DISCONNECTED
+        const int COMMAND_QUEUE_LENGTH = 16;
+        const size_t MAX_FRAME_SIZE = 96 * 1024;    // Matches RemoteSigner::Config::MAX_FRAME_SIZE
+    }
+}
@@ -0,0 +1,534 @@
+#include "relay_pool.h"
+#include "relay_url.h"
+#include "cert_pins.h"
+#include "remote_signer.h"
+#include "wifi_manager.h"
+#include "metrics.h"
+#include <Preferences.h>
+#include <WebSocketsClient.h>
+#include <WiFi.h>
+#include <signer_trace.h>
+
+namespace RelayPool {
+    typedef enum {
+        COMMAND_CONFIGURE,
+        COMMAND_EVENT
+    } command_type_t;
+
+    struct Command {
+        command_type_t type;
+        pool_mode_t mode;           // COMMAND_CONFIGURE
+        char* text;                 // Relay URLs or event JSON, owned by the command
+        unsigned long signedAt;     // COMMAND_EVENT
+        char* allowList;            // COMMAND_CONFIGURE: ws:// allow-list snapshot, owned by the command
+    };
+
+    struct Relay {
+        WebSocketsClient client;
+        bool active = false;
+        char host[64] = "";
+        // Written by the pool task, read for reports
+        volatile bool connected = false;
+        volatile uint32_t ok = 0;
+        volatile uint32_t rejected = 0;
+        volatile uint32_t timeouts = 0;
+        volatile uint32_t lastAckMs = 0;
+    };
+
+    // An event waiting for OK replies (publish) or for the client's copy to show up (watch)
+    struct Pending {
+        bool active = false;
+        char id[65];
+        unsigned long signedAt;
+        uint8_t sent;               // Relay bitmasks
+        uint8_t answered;
+        bool published;
+    };
+
+    static pool_mode_t pool_mode = POOL_OFF;
+    static String relay_urls = "";
+    static String configured_allow_list = "";   // Last snapshot handed to the pool task
+
+    // Owned by the pool task
+    static Relay relays[Config::MAX_RELAYS];
+    static Pending pending[Config::MAX_PENDING];
+    static pool_mode_t task_mode = POOL_OFF;
+
+    // Time to published by path, for the report
+    static volatile uint32_t device_published = 0;
+    static volatile uint32_t device_published_ms = 0;
+    static volatile uint32_t client_published = 0;
+    static volatile uint32_t client_published_ms = 0;
+
+    static TaskHandle_t pool_task_handle = NULL;
+    static QueueHandle_t command_queue = NULL;
+
+    static char* copyString(const String& text) {
+        char* copy = (char*)malloc(text.length() + 1);
+        if (copy != nullptr) {
+            memcpy(copy, text.c_str(), text.length() + 1);
+        }
+        return copy;
+    }
+
+    // Subscription id for watching an event: a prefix of the event id
+    static String watchSubscription(const char* eventId) {
+        return "w" + String(eventId).substring(0, 32);
+    }
+
+    // ["OK","<id>",true,"..."] and ["EVENT","<sub id>",{...}] both carry a string second
+    static bool secondElement(const String& message, String& value, int& end) {
+        int start = message.indexOf('"', message.indexOf(',') + 1);
+        int stop = start == -1 ? -1 : message.indexOf('"', start + 1);
+        if (stop == -1) {
+            return false;
+        }
+        value = message.substring(start + 1, stop);
+        end = stop + 1;
+        return true;
+    }
+
+    static void finishIfAnswered(Pending& entry) {
+        if ((entry.answered & entry.sent) == entry.sent) {
+            entry.active = false;
+        }
+    }
+
+    static void recordPublished(Pending& entry, bool byDevice) {
+        if (entry.published) {
+            return;
+        }
+        entry.published = true;
+        uint32_t elapsed = millis() - entry.signedAt;
+        if (byDevice) {
+            Metrics::observe("signer_publish_time_ms{path=\"device\"}", elapsed);
+            device_published++;
+            device_published_ms += elapsed;
+        } else {
+            Metrics::observe("signer_publish_time_ms{path=\"client\"}", elapsed);
+            client_published++;
+            client_published_ms += elapsed;
+        }
+    }
+
+    static void handleOk(int index, const String& message) {
+        String eventId;
+        int end;
+        if (!secondElement(message, eventId, end)) {
+            return;
+        }
+        String rest = message.substring(message.indexOf(',', end) + 1);
+        rest.trim();
+        bool accepted = rest.startsWith("true");
+
+        for (int i = 0; i < Config::MAX_PENDING; i++) {
+            Pending& entry = pending[i];
+            if (!entry.active || eventId != entry.id || !(entry.sent & (1 << index))) {
+                continue;
+            }
+            entry.answered |= 1 << index;
+            Relay& relay = relays[index];
+            if (accepted) {
+                relay.ok++;
+                relay.lastAckMs = millis() - entry.signedAt;
+                Metrics::increment("signer_publish_ok_total");
+                recordPublished(entry, true);
+            } else {
+                relay.rejected++;
+                Metrics::increment("signer_publish_rejected_total");
+                Serial.println("RelayPool::handleOk() - " + String(relay.host) + " rejected " + eventId.substring(0, 16) + ": " + rest);
+            }
+            finishIfAnswered(entry);
+            return;
+        }
+    }
+
+    static void handleWatchedEvent(int index, const String& message) {
+        String subscription;
+        int end;
+        if (!secondElement(message, subscription, end)) {
+            return;
+        }
+        for (int i = 0; i < Config::MAX_PENDING; i++) {
+            Pending& entry = pending[i];
+            if (!entry.active || !(entry.sent & (1 << index)) || (entry.answered & (1 << index)) || subscription != watchSubscription(entry.id)) {
+                continue;
+            }
+            entry.answered |= 1 << index;
+            relays[index].ok++;
+            relays[index].lastAckMs = millis() - entry.signedAt;
+            String close = "[\"CLOSE\",\"" + subscription + "\"]";
+            relays[index].client.sendTXT(close);
+            recordPublished(entry, false);
+            finishIfAnswered(entry);
+            return;
+        }
+    }
+
+    static void relayEvent(int index, WStype_t type, uint8_t* payload, size_t length) {
+        switch (type) {
+            case WStype_CONNECTED:
+                relays[index].connected = true;
+                Serial.println("RelayPool::relayEvent() - Connected to " + String(relays[index].host));
+                break;
+            case WStype_DISCONNECTED:
+                if (relays[index].connected) {
+                    Serial.println("RelayPool::relayEvent() - Disconnected from " + String(relays[index].host));
+                }
+                relays[index].connected = false;
+                break;
+            case WStype_TEXT: {
+                String message = String((char*)payload);
+                if (message.startsWith("[\"OK\"")) {
+                    handleOk(index, message);
+                } else if (message.startsWith("[\"EVENT\"") && task_mode == POOL_WATCH) {
+                    handleWatchedEvent(index, message);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    static void applyConfigure(pool_mode_t mode, const char* urls, const char* allowList) {
+        for (int i = 0; i < Config::MAX_RELAYS; i++) {
+            if (relays[i].active) {
+                relays[i].client.disconnect();
+                relays[i].active = false;
+                relays[i].connected = false;
+            }
+        }
+        for (int i = 0; i < Config::MAX_PENDING; i++) {
+            pending[i].active = false;
+        }
+        task_mode = mode;
+        if (mode == POOL_OFF) {
+            Serial.println("RelayPool::applyConfigure() - Pool closed");
+            return;
+        }
+
+        String list = urls;
+        int start = 0;
+        int index = 0;
+        while (start < (int)list.length() && index < Config::MAX_RELAYS) {
+            int end = list.indexOf(',', start);
+            if (end == -1) {
+                end = list.length();
+            }
+            String url = list.substring(start, end);
+            start = end + 1;
+
+            RelayUrl::Parts parts;
+            if (!RelayUrl::parse(url, parts)) {
+                continue;
+            }
+
+            Relay& relay = relays[index];
+            strncpy(relay.host, parts.host.c_str(), sizeof(relay.host) - 1);
+            relay.host[sizeof(relay.host) - 1] = '\0';
+            if (parts.secure) {
+                // Same verification as the signer relay, see RelayLink::applyConnect()
+#ifdef RELAY_CA_BUNDLE
+                if (CertPins::getMode() == CertPins::TLS_VERIFY_CHAIN) {
+#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3, 0, 4)
+                    relay.client.beginSslWithBundle(parts.host.c_str(), parts.port, parts.path.c_str(), relay_ca_bundle_start, relay_ca_bundle_end - relay_ca_bundle_start);
+#else
+                    relay.client.beginSslWithBundle(parts.host.c_str(), parts.port, parts.path.c_str(), relay_ca_bundle_start);
+#endif
+                } else
+#endif
+                {
+                    relay.client.beginSSL(parts.host.c_str(), parts.port, parts.path.c_str());
+                }
+                if (CertPins::getMode() == CertPins::TLS_VERIFY_PIN) {
+                    String hostPort = parts.host + ":" + String(parts.port);
+                    relay.client.setPeerCertVerifier([hostPort](const mbedtls_x509_crt *cert) {
+                        return CertPins::verifyPeer(hostPort, cert);
+                    });
+                } else {
+                    relay.client.setPeerCertVerifier(nullptr);
+                }
+                relay.client.clearConnectAddress();
+            } else {
+                // The allow-list must also cover the address the name resolves to
+                IPAddress address;
+                if (WiFi.hostByName(parts.host.c_str(), address) != 1 || !RelayUrl::isPlaintextAllowed(address.toString(), allowList)) {
+                    Serial.println("RelayPool::applyConfigure() - Refusing ws:// to " + parts.host + ", its address is not on the allow-list");
+                    Metrics::increment("signer_relay_plaintext_refused_total");
+                    continue;
+                }
+                relay.client.begin(parts.host.c_str(), parts.port, parts.path.c_str());
+                relay.client.setConnectAddress(address);
+                relay.client.setPeerCertVerifier(nullptr);
+            }
+            relay.client.onEvent([index](WStype_t type, uint8_t* payload, size_t length) {
+                relayEvent(index, type, payload, length);
+            });
+            relay.client.setReconnectInterval(Config::RECONNECT_INTERVAL_MS);
+            relay.client.enableHeartbeat(Config::HEARTBEAT_INTERVAL_MS, Config::HEARTBEAT_TIMEOUT_MS, 2);
+            relay.active = true;
+            index++;
+        }
+        Serial.println("RelayPool::applyConfigure() - " + String(getModeName(mode)) + " mode with " + String(index) + " write relay(s)");
+    }
+
+    static void applyEvent(const char* event, unsigned long signedAt) {
+        TRACE_SCOPE("relay_pool_publish");
+        const char* idStart = strstr(event, "\"id\":\"");
+        if (idStart == nullptr || strlen(idStart) < 6 + 64) {
+            return;
+        }
+
+        // Reuse a free slot, or give up on the oldest event
+        Pending* entry = &pending[0];
+        for (int i = 0; i < Config::MAX_PENDING; i++) {
+            if (!pending[i].active) {
+                entry = &pending[i];
+                break;
+            }
+            if ((long)(pending[i].signedAt - entry->signedAt) < 0) {
+                entry = &pending[i];
+            }
+        }
+        if (entry->active && !entry->published) {
+            Metrics::increment("signer_publish_timeouts_total");
+        }
+
+        memcpy(entry->id, idStart + 6, 64);
+        entry->id[64] = '\0';
+        entry->signedAt = signedAt;
+        entry->sent = 0;
+        entry->answered = 0;
+        entry->published = false;
+
+        String message = task_mode == POOL_PUBLISH
+            ? "[\"EVENT\"," + String(event) + "]"
+            : "[\"REQ\",\"" + watchSubscription(entry->id) + "\",{\"ids\":[\"" + String(entry->id) + "\"]}]";
+        for (int i = 0; i < Config::MAX_RELAYS; i++) {
+            if (relays[i].active && relays[i].connected && relays[i].client.sendTXT(message)) {
+                entry->sent |= 1 << i;
+            }
+        }
+
+        entry->active = entry->sent != 0;
+        if (!entry->active) {
+            Metrics::increment("signer_publish_unsent_total");
+            Serial.println("RelayPool::applyEvent() - No write relay connected, " + String(entry->id).substring(0, 16) + " not sent");
+        }
+    }
+
+    static void checkTimeouts() {
+        unsigned long now = millis();
+        for (int i = 0; i < Config::MAX_PENDING; i++) {
+            Pending& entry = pending[i];
+            if (!entry.active || now - entry.signedAt < Config::ACK_TIMEOUT_MS) {
+                continue;
+            }
+            for (int r = 0; r < Config::MAX_RELAYS; r++) {
+                if ((entry.sent & (1 << r)) && !(entry.answered & (1 << r))) {
+                    relays[r].timeouts++;
+                    if (task_mode == POOL_WATCH && relays[r].connected) {
+                        String close = "[\"CLOSE\",\"" + watchSubscription(entry.id) + "\"]";
+                        relays[r].client.sendTXT(close);
+                    }
+                }
+            }
+            if (!entry.published) {
+                Metrics::increment("signer_publish_timeouts_total");
+            }
+            entry.active = false;
+        }
+    }
+
+    static void poolTask(void* parameter) {
+        while (true) {
+            // Sleep until configured; then poll the sockets between commands
+            Command command;
+            TickType_t wait = task_mode == POOL_OFF ? portMAX_DELAY : pdMS_TO_TICKS(Config::POLL_INTERVAL_MS);
+            while (xQueueReceive(command_queue, &command, wait) == pdTRUE) {
+                if (command.type == COMMAND_CONFIGURE) {
+                    applyConfigure(command.mode, command.text, command.allowList);
+                } else if (task_mode != POOL_OFF) {
+                    applyEvent(command.text, command.signedAt);
+                }
+                free(command.text);
+                free(command.allowList);
+                wait = 0;
+            }
+
+            if (task_mode == POOL_OFF || !WiFiManager::isConnected() || WiFiManager::isBackgroundOperationsPaused()) {
+                continue;
+            }
+            for (int i = 0; i < Config::MAX_RELAYS; i++) {
+                if (relays[i].active) {
+                    relays[i].client.loop();
+                }
+            }
+            checkTimeouts();
+        }
+    }
+
+    static bool queueCommand(Command& command) {
+        if (pool_task_handle == NULL) {
+            command_queue = xQueueCreate(Config::QUEUE_LENGTH, sizeof(Command));
+            xTaskCreatePinnedToCore(
+                poolTask,
+                "RelayPool",
+                Config::TASK_STACK_SIZE,
+                NULL,
+                Config::TASK_PRIORITY,
+                &pool_task_handle,
+                Config::TASK_CORE
+            );
+        }
+        bool complete = command.text != nullptr && (command.type != COMMAND_CONFIGURE || command.allowList != nullptr);
+        if (!complete || xQueueSend(command_queue, &command, 0) != pdTRUE) {
+            free(command.text);
+            free(command.allowList);
+            return false;
+        }
+        return true;
+    }
+
+    // Every URL must parse, and ws:// ones must be on the signer's allow-list
+    static bool validateUrls(const String& relayUrls, const String& allowList) {
+        int start = 0;
+        int count = 0;
+        while (start < (int)relayUrls.length()) {
+            int end = relayUrls.indexOf(',', start);
+            if (end == -1) {
+                end = relayUrls.length();
+            }
+            String url = relayUrls.substring(start, end);
+            url.trim();
+            start = end + 1;
+            if (url.length() == 0) {
+                continue;
+            }
+            RelayUrl::Parts parts;
+            if (!RelayUrl::parse(url, parts) || (!parts.secure && !RelayUrl::isPlaintextAllowed(parts.host, allowList))) {
+                Serial.println("RelayPool::validateUrls() - Rejected write relay " + url);
+                return false;
+            }
+            count++;
+        }
+        return count <= Config::MAX_RELAYS;
+    }
+
+    bool validate(const String& relayUrls, const String& allowList) {
+        return validateUrls(relayUrls, allowList);
+    }
+
+    void init() {
+        Preferences prefs;
+        prefs.begin(Config::PREFS_NAMESPACE, true);
+        pool_mode = (pool_mode_t)prefs.getUChar("mode", POOL_OFF);
+        relay_urls = prefs.getString("urls", "");
+        prefs.end();
+
+        configured_allow_list = RemoteSigner::getPlaintextAllowList();
+        if (pool_mode != POOL_OFF && validateUrls(relay_urls, configured_allow_list)) {
+            Command command = { COMMAND_CONFIGURE, pool_mode, copyString(relay_urls), 0, copyString(configured_allow_list) };
+            queueCommand(command);
+        } else if (pool_mode != POOL_OFF) {
+            Serial.println("RelayPool::init() - Stored write relays are invalid, pool stays closed");
+            pool_mode = POOL_OFF;
+        }
+    }
+
+    pool_mode_t getMode() {
+        return pool_mode;
+    }
+
+    const char* getModeName(pool_mode_t mode) {
+        switch (mode) {
+            case POOL_WATCH:
+                return "watch";
+            case POOL_PUBLISH:
+                return "publish";
+            default:
+                return "off";
+        }
+    }
+
+    String getRelayUrls() {
+        return relay_urls;
+    }
+
+    bool configure(pool_mode_t mode, const String& relayUrls) {
+        // Read here on the caller's task; the pool task only sees the snapshot
+        String allowList = RemoteSigner::getPlaintextAllowList();
+        if (!validateUrls(relayUrls, allowList)) {
+            return false;
+        }
+        if (mode != POOL_OFF && relayUrls.length() == 0) {
+            mode = POOL_OFF;
+        }
+
+        Preferences prefs;
+        if (prefs.begin(Config::PREFS_NAMESPACE, false)) {
+            prefs.putUChar("mode", mode);
+            prefs.putString("urls", relayUrls);
+            prefs.end();
+        }
+
+        // Nothing to close if the pool was never opened
+        bool changed = mode != pool_mode || relayUrls != relay_urls || allowList != configured_allow_list;
+        pool_mode = mode;
+        relay_urls = relayUrls;
+        configured_allow_list = allowList;
+        if (changed && (mode != POOL_OFF || pool_task_handle != NULL)) {
+            Command command = { COMMAND_CONFIGURE, mode, copyString(relayUrls), 0, copyString(allowList) };
+            queueCommand(command);
+        }
+        Serial.println("RelayPool::configure() - Mode " + String(getModeName(mode)) + ", write relays: " + relayUrls);
+        return true;
+    }
+
+    void forgetPins() {
+        int start = 0;
+        while (start < (int)relay_urls.length()) {
+            int end = relay_urls.indexOf(',', start);
+            if (end == -1) {
+                end = relay_urls.length();
+            }
+            String url = relay_urls.substring(start, end);
+            url.trim();
+            start = end + 1;
+
+            RelayUrl::Parts parts;
+            if (RelayUrl::parse(url, parts) && parts.secure) {
+                CertPins::forget(parts.host + ":" + String(parts.port));
+            }
+        }
+    }
+
+    void eventSigned(const String& signedEvent) {
+        if (pool_mode == POOL_OFF) {
+            return;
+        }
+        Command command = { COMMAND_EVENT, pool_mode, copyString(signedEvent), millis(), nullptr };
+        if (!queueCommand(command)) {
+            Metrics::increment("signer_publish_unsent_total");
+        }
+    }
+
+    String getReport() {
+        if (pool_mode == POOL_OFF) {
+            return "";
+        }
+        String report = "Write relays (" + String(getModeName(pool_mode)) + "):\n";
+        for (int i = 0; i < Config::MAX_RELAYS; i++) {
+            const Relay& relay = relays[i];
+            if (!relay.active) {
+                continue;
+            }
+            report += String(relay.host) + ": " + (relay.connected ? "up" : "down") + ", " + String(relay.ok) + (pool_mode == POOL_PUBLISH ? " ok, " : " seen, ") +
+                      String(relay.rejected) + " rejected, " + String(relay.timeouts) + " timeouts, last " + String(relay.lastAckMs) + " ms\n";
+        }
+        report += "Time to published: device " + (device_published > 0 ? String(device_published_ms / device_published) + " ms avg (" + String(device_published) + ")" : String("-")) +
+                  ", client " + (client_published > 0 ? String(client_published_ms / client_published) + " ms avg (" + String(client_published) + ")" : String("-"));
+        return report;
+    }
+}
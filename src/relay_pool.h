@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Pooled connections to the user's write relays.
+ *
+ * Publish mode sends every event signed for a NIP-46 client to each write
+ * relay straight from the device, in parallel with the NIP-46 response. The
+ * client then does not need its own publish round trip. OK replies are
+ * tracked per relay.
+ *
+ * Watch mode leaves publishing to the client and subscribes to each signed
+ * event's id instead, so the time until the client's copy reaches the
+ * write relays can be measured the same way. Both paths are reported as
+ * signer_publish_time_ms, measured from signing to the first relay that
+ * has the event.
+ *
+ * The connections run on their own task on the WiFi core and are opened
+ * only while a mode other than off is configured.
+ */
+namespace RelayPool {
+    typedef enum {
+        POOL_OFF,
+        POOL_WATCH,
+        POOL_PUBLISH
+    } pool_mode_t;
+
+    void init();
+
+    pool_mode_t getMode();
+    const char* getModeName(pool_mode_t mode);
+    String getRelayUrls();
+    // Up to MAX_RELAYS parseable URLs, ws:// ones only for hosts on allowList
+    bool validate(const String& relayUrls, const String& allowList);
+    // Persisted, and applied to the pool connections right away
+    bool configure(pool_mode_t mode, const String& relayUrls);
+    // Clears the stored TLS pins of the configured wss:// write relays
+    void forgetPins();
+
+    // signedEvent is the event JSON object as returned by nostr::getNote()
+    void eventSigned(const String& signedEvent);
+
+    String getReport();
+
+    namespace Config {
+        const char* const PREFS_NAMESPACE = "relay_pool";
+        const int MAX_RELAYS = 3;
+        const int MAX_PENDING = 8;                  // Events awaiting OK / appearance
+        const unsigned long ACK_TIMEOUT_MS = 10000;
+        const int QUEUE_LENGTH = 8;
+        const uint32_t TASK_STACK_SIZE = 8192;
+        const UBaseType_t TASK_PRIORITY = 1;
+        const BaseType_t TASK_CORE = 0;
+        const uint32_t POLL_INTERVAL_MS = 5;
+        const unsigned long RECONNECT_INTERVAL_MS = 5000;
+        const uint32_t HEARTBEAT_INTERVAL_MS = 15000;
+        const uint32_t HEARTBEAT_TIMEOUT_MS = 3000;
+    }
+}
@@ -0,0 +1,120 @@
+#include "relay_url.h"
+#include <IPAddress.h>
+
+namespace RelayUrl {
+    bool parse(const String& url, Parts& parts) {
+        String rest = url;
+        rest.trim();
+
+        String lower = rest;
+        lower.toLowerCase();
+        if (lower.startsWith("wss://")) {
+            parts.secure = true;
+            parts.port = 443;
+            rest = rest.substring(6);
+        } else if (lower.startsWith("ws://")) {
+            parts.secure = false;
+            parts.port = 80;
+            rest = rest.substring(5);
+        } else {
+            return false;
+        }
+
+        int fragment = rest.indexOf('#');
+        if (fragment != -1) {
+            rest = rest.substring(0, fragment);
+        }
+
+        // Authority ends at the first '/' or '?'
+        int authorityEnd = rest.length();
+        int slash = rest.indexOf('/');
+        int query = rest.indexOf('?');
+        if (slash != -1) {
+            authorityEnd = slash;
+        }
+        if (query != -1 && query < authorityEnd) {
+            authorityEnd = query;
+        }
+        String authority = rest.substring(0, authorityEnd);
+        String path = rest.substring(authorityEnd);
+        if (path.length() == 0 || path[0] == '?') {
+            path = "/" + path;
+        }
+
+        if (authority.indexOf('@') != -1 || authority.indexOf('[') != -1) {
+            return false;
+        }
+
+        String host = authority;
+        int colon = authority.indexOf(':');
+        if (colon != -1) {
+            String portText = authority.substring(colon + 1);
+            if (portText.length() == 0 || portText.length() > 5) {
+                return false;
+            }
+            for (unsigned int i = 0; i < portText.length(); i++) {
+                if (!isDigit(portText[i])) {
+                    return false;
+                }
+            }
+            long port = portText.toInt();
+            if (port < 1 || port > 65535) {
+                return false;
+            }
+            parts.port = port;
+            host = authority.substring(0, colon);
+        }
+
+        host.toLowerCase();
+        if (host.length() == 0 || host.length() > 253) {
+            return false;
+        }
+        for (unsigned int i = 0; i < host.length(); i++) {
+            char c = host[i];
+            if (!isAlphaNumeric(c) && c != '-' && c != '.') {
+                return false;
+            }
+        }
+
+        parts.host = host;
+        parts.path = path;
+        return true;
+    }
+
+    static bool matchesEntry(const String& host, const String& entry) {
+        int slash = entry.indexOf('/');
+        if (slash == -1) {
+            return host.equalsIgnoreCase(entry);
+        }
+
+        IPAddress hostAddress;
+        IPAddress network;
+        int prefix = entry.substring(slash + 1).toInt();
+        if (!hostAddress.fromString(host) || !network.fromString(entry.substring(0, slash)) || prefix < 0 || prefix > 32) {
+            return false;
+        }
+
+        // IPAddress stores octets in network order; compare as big-endian integers
+        uint32_t mask = prefix == 0 ? 0 : 0xFFFFFFFFUL << (32 - prefix);
+        uint32_t hostBits = ((uint32_t)hostAddress[0] << 24) | ((uint32_t)hostAddress[1] << 16) | ((uint32_t)hostAddress[2] << 8) | hostAddress[3];
+        uint32_t networkBits = ((uint32_t)network[0] << 24) | ((uint32_t)network[1] << 16) | ((uint32_t)network[2] << 8) | network[3];
+        return (hostBits & mask) == (networkBits & mask);
+    }
+
+    bool isPlaintextAllowed(const String& host, const String& allowList) {
+        int start = 0;
+        while (start < (int)allowList.length()) {
+            int end = allowList.indexOf(',', start);
+            if (end == -1) {
+                end = allowList.length();
+            }
+            String entry = allowList.substring(start, end);
+            entry.trim();
+            if (entry.length() > 0 && matchesEntry(host, entry)) {
+                return true;
+            }
+            start = end + 1;
+        }
+        return false;
+    }
+}
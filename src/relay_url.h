@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Relay URL parsing and the plain ws:// allow-list.
+ *
+ * Accepts ws://host[:port][/path][?query] and the wss:// equivalent.
+ * Ports default to 80 and 443, and the path defaults to "/". Fragments are
+ * dropped; userinfo and IPv6 literals are rejected.
+ *
+ * Unencrypted ws:// is only used for hosts on the operator's allow-list:
+ * a comma-separated list of host names, IPv4 addresses and IPv4 CIDR
+ * ranges (e.g. "relay.lan, 192.168.1.0/24"). CIDR ranges only match hosts
+ * given as IPv4 literals in the URL.
+ *
+ * A listed name only admits the URL. The address it resolves to is
+ * checked again before connecting and must be on the list as an address
+ * or range, so a spoofed lookup cannot send plaintext off the LAN.
+ */
+namespace RelayUrl {
+    struct Parts {
+        bool secure = true;
+        String host;
+        uint16_t port = 443;
+        String path = "/";
+    };
+
+    bool parse(const String& url, Parts& parts);
+    bool isPlaintextAllowed(const String& host, const String& allowList);
+}
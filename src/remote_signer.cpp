@@ -4,14 +4,27 @@
 #include "app.h"
 #include "display.h"
 #include "wifi_manager.h"
+#include "peer_coordinator.h"
+#include "metrics.h"
+#include "status_model.h"
+#include "relay_url.h"
+#include "cert_pins.h"
+#include "relay_link.h"
+#include "relay_pool.h"
 #include <Preferences.h>
+#include <signer_trace.h>
 #include "lvgl.h"
 
 // Import Nostr library components from lib/ folder
 #include "../lib/nostr/nostr.h"
+#include "../lib/nostr/envelope.h"
 #include "../lib/nostr/nip44/nip44.h"
 #include "../lib/nostr/nip19.h"
 
+// The WebSockets library allocates whole frames; it must refuse anything we would drop anyway
+static_assert(WEBSOCKETS_MAX_DATA_SIZE == RemoteSigner::Config::MAX_FRAME_SIZE, "WEBSOCKETS_MAX_DATA_SIZE must match RemoteSigner::Config::MAX_FRAME_SIZE");
+static_assert(RelayLink::Config::MAX_FRAME_SIZE == RemoteSigner::Config::MAX_FRAME_SIZE, "RelayLink and RemoteSigner frame caps must match");
+
 namespace RemoteSigner
 {
     // NIP-46 Method constants
@@ -27,12 +40,26 @@ namespace RemoteSigner
         const char *NIP44_DECRYPT = "nip44_decrypt";
     }
 
-    // WebSocket client
-    static WebSocketsClient webSocket;
+    static const char *requestMetricName(const String &method)
+    {
+        if (method == Methods::CONNECT) return "signer_requests_total{method=\"connect\"}";
+        if (method == Methods::SIGN_EVENT) return "signer_requests_total{method=\"sign_event\"}";
+        if (method == Methods::PING) return "signer_requests_total{method=\"ping\"}";
+        if (method == Methods::GET_PUBLIC_KEY) return "signer_requests_total{method=\"get_public_key\"}";
+        if (method == Methods::NIP04_ENCRYPT) return "signer_requests_total{method=\"nip04_encrypt\"}";
+        if (method == Methods::NIP04_DECRYPT) return "signer_requests_total{method=\"nip04_decrypt\"}";
+        if (method == Methods::NIP44_ENCRYPT) return "signer_requests_total{method=\"nip44_encrypt\"}";
+        if (method == Methods::NIP44_DECRYPT) return "signer_requests_total{method=\"nip44_decrypt\"}";
+        return "signer_requests_total{method=\"unknown\"}";
+    }
+
+    // The WebSocket client itself lives on the RelayLink network task
     static unsigned long last_loop_time = 0;
 
     // Configuration
     static String relayUrl = "";
+    static String plaintextAllowList = ""; // Hosts allowed over unencrypted ws://, see RelayUrl
+    static unsigned long requestTimeoutSeconds = Config::DEFAULT_REQUEST_TIMEOUT_S;
 
     // User's keypair (for signing actual events)
     static String userPrivateKeyHex = "";
@@ -44,12 +71,24 @@ namespace RemoteSigner
 
     static String secretKey = "";
     static String authorizedClients = "";
+    static String replying_to_event_id = "";  // Request being answered, tagged on its reply in peer mode
+    static String loopbackClients = ""; // Simulated clients while LoadGenerator runs; never persisted
 
     // Client management constants
     static const int MAX_AUTHORIZED_CLIENTS = 30; // Limit to prevent NVS overflow
 
+    // Load-test traffic: no UI, backlight or publishing side effects
+    static bool isLoopbackClient(const char *clientPubKey)
+    {
+        return loopbackClients.length() > 0 && clientPubKey[0] != '\0' && loopbackClients.indexOf(clientPubKey) != -1;
+    }
+
     // Forward declarations for helper functions
     void generateDeviceKeypair();
+    static bool isKnownClient(const char *clientPubKey);
+    static void publishClientCount();
+    static void sendHeartbeat();
+    static bool sendSubscriptions();
 
     // Connection state
     static bool signer_initialized = false;
@@ -57,9 +96,16 @@ namespace RemoteSigner
     static unsigned long last_connection_attempt = 0;
     static unsigned long last_ws_ping = 0;
     static unsigned long last_ws_message_received = 0;
+    static unsigned long last_ws_ping_sent = 0; // Outstanding ping for RTT, 0 when none
+    static unsigned long relay_event_received = 0; // When the RelayLink task received the event being handled
+    static bool relay_secure = true;
+    static CertPins::verify_mode_t relay_verify_mode = CertPins::Config::DEFAULT_MODE;
+    static unsigned long relay_begin_time = 0;    // Connect requested and not yet through, 0 once connected
+    static unsigned long relay_connect_started = 0; // WStype_CONNECTED: when the TCP connect began, after the lookup
     static int reconnection_attempts = 0;
     static unsigned long last_reconnect_attempt = 0;
     static bool manual_reconnect_needed = false;
+    static bool subscription_pending = false; // Connected but the REQ did not fit in the outbound queue
 
     // WebSocket fragment management
     static bool ws_fragment_in_progress = false;
@@ -77,7 +123,10 @@ namespace RemoteSigner
     // Status callback
     static signer_status_callback_t status_callback = nullptr;
     static signing_confirmation_callback_t signing_callback = nullptr;
-    static lv_obj_t *status_label = nullptr;
+
+    // Token bucket limiting decrypt work for senders we don't know
+    static int unknown_sender_tokens = Config::UNKNOWN_SENDER_BURST;
+    static unsigned long last_token_refill = 0;
 
     // Memory allocation for JSON documents
     static const size_t JSON_DOC_SIZE = 100000;
@@ -97,6 +146,15 @@ namespace RemoteSigner
 
         // Generate initial secret key
         refreshSecretKey();
+        displayConnectionStatus(false);
+
+        // Load peer identity for active-active signer pairs
+        PeerCoordinator::init();
+        CertPins::init();
+
+        // Socket I/O runs on its own task from here on
+        RelayLink::init();
+        RelayPool::init();
 
         // Initialize time client
         timeClient.begin();
@@ -110,6 +168,8 @@ namespace RemoteSigner
         Serial.println("RemoteSigner::cleanup() - Cleaning up Remote Signer module");
 
         disconnect();
+        RelayLink::cleanup();
+        clearInFlightRequests();
         signer_initialized = false;
 
         Serial.println("RemoteSigner::cleanup() - Remote Signer module cleaned up");
@@ -121,6 +181,8 @@ namespace RemoteSigner
         prefs.begin("signer", true); // Read-only
 
         relayUrl = prefs.getString("relay_url", "wss://relay.nostrconnect.com");
+        plaintextAllowList = prefs.getString("ws_allow", "");
+        requestTimeoutSeconds = constrain(prefs.getULong("req_timeout", Config::DEFAULT_REQUEST_TIMEOUT_S), Config::MIN_REQUEST_TIMEOUT_S, Config::MAX_REQUEST_TIMEOUT_S);
 
         userPrivateKeyHex = prefs.getString("usr_priv_key", "");
         if (userPrivateKeyHex.length() == 0)
@@ -196,6 +258,8 @@ namespace RemoteSigner
         authorizedClients = prefs.getString("auth_clients", "");
 
         prefs.end();
+
+        publishClientCount();
     }
 
     void saveConfigToPreferences()
@@ -227,6 +291,15 @@ namespace RemoteSigner
         return "bunker://" + devicePublicKeyHex + "?relay=" + relayUrl + "&secret=" + secretKey;
     }
 
+    // Handshake timings are split by transport and, for wss://, certificate check
+    static const char *handshakeMetricName()
+    {
+        if (!relay_secure) return "signer_relay_handshake_duration_ms{transport=\"ws\"}";
+        if (relay_verify_mode == CertPins::TLS_VERIFY_NONE) return "signer_relay_handshake_duration_ms{transport=\"wss\",verify=\"none\"}";
+        if (relay_verify_mode == CertPins::TLS_VERIFY_CHAIN) return "signer_relay_handshake_duration_ms{transport=\"wss\",verify=\"chain\"}";
+        return "signer_relay_handshake_duration_ms{transport=\"wss\",verify=\"pin\"}";
+    }
+
     void connectToRelay()
     {
         if (!signer_initialized || relayUrl.length() == 0)
@@ -247,6 +320,28 @@ namespace RemoteSigner
             return;
         }
 
+        RelayUrl::Parts relay;
+        if (!RelayUrl::parse(relayUrl, relay))
+        {
+            Serial.println("RemoteSigner::connectToRelay() - Cannot connect: invalid relay URL " + relayUrl);
+            if (status_callback)
+            {
+                status_callback(false, "Invalid relay URL");
+            }
+            return;
+        }
+
+        if (!relay.secure && !RelayUrl::isPlaintextAllowed(relay.host, plaintextAllowList))
+        {
+            Serial.println("RemoteSigner::connectToRelay() - Cannot connect: ws:// is only allowed for relays on the LAN allow-list, " + relay.host + " is not listed");
+            if (status_callback)
+            {
+                status_callback(false, "ws:// relay not allowed");
+            }
+            return;
+        }
+
+        TRACE_SCOPE("signer_relay_connect");
         Serial.println("RemoteSigner::connectToRelay() - Connecting to relay: " + relayUrl);
         Serial.println("Connection attempt #" + String(reconnection_attempts + 1) + " of " + String(Config::MAX_RECONNECT_ATTEMPTS));
 
@@ -256,14 +351,29 @@ namespace RemoteSigner
         // Update status display immediately
         displayConnectionStatus(false);
 
-        // Extract hostname from relay URL (remove wss:// prefix)
-        String hostname = relayUrl;
-        hostname.replace("wss://", "");
-        hostname.replace("ws://", "");
-
-        webSocket.beginSSL(hostname.c_str(), 443, "/");
-        webSocket.onEvent(websocketEvent);
-        webSocket.setReconnectInterval(Config::MIN_RECONNECT_INTERVAL);
+        String hostname = relay.host;
+        relay_secure = relay.secure;
+
+        RelayLink::ConnectParams params;
+        params.host = hostname;
+        params.port = relay.port;
+        params.path = relay.path;
+        params.secure = relay.secure;
+        params.reconnectInterval = Config::MIN_RECONNECT_INTERVAL;
+        // The network task resolves through DnsCache, so lookups never block this loop
+        params.useDnsCache = true;
+        params.plaintextAllowList = plaintextAllowList;
+        if (relay.secure)
+        {
+            relay_verify_mode = CertPins::getMode();
+            params.useCaBundle = relay_verify_mode == CertPins::TLS_VERIFY_CHAIN;
+            if (relay_verify_mode == CertPins::TLS_VERIFY_PIN)
+            {
+                params.pinHostPort = hostname + ":" + String(relay.port);
+            }
+        }
+        relay_begin_time = millis();
+        RelayLink::connect(params);
 
         if (status_callback)
         {
@@ -276,7 +386,7 @@ namespace RemoteSigner
         Serial.println("RemoteSigner::disconnect() - Disconnecting from relay");
         Serial.println("Connection was active for: " + String((millis() - last_connection_attempt) / 1000) + "s");
 
-        webSocket.disconnect();
+        RelayLink::disconnect();
         connection_in_progress = false;
 
         // Update status display immediately
@@ -294,7 +404,17 @@ namespace RemoteSigner
         {
         case WStype_DISCONNECTED:
             Serial.println("RemoteSigner::websocketEvent() - WebSocket Disconnected");
+            Trace::instant("relay_disconnected");
+            subscription_pending = false;
+            if (relay_begin_time != 0)
+            {
+                // Never got through the handshake; the reconnect tries the next address
+                RelayLink::tryNextAddress();
+                relay_begin_time = 0;
+            }
             connection_in_progress = false;
+            Metrics::increment("signer_relay_disconnects_total");
+            Metrics::setGauge("signer_relay_connected", 0);
 
             // Update status display immediately
             displayConnectionStatus(false);
@@ -322,21 +442,25 @@ namespace RemoteSigner
 
         case WStype_CONNECTED:
             Serial.println("RemoteSigner::websocketEvent() - WebSocket Connected to: " + String((char *)payload));
+            Trace::instant("relay_connected");
             connection_in_progress = false;
             reconnection_attempts = 0;
             manual_reconnect_needed = false;
             last_ws_message_received = millis();
+            if (relay_begin_time != 0)
+            {
+                // Lookup time is in signer_relay_resolve_duration_ms, not here
+                Metrics::observe(handshakeMetricName(), relay_event_received - relay_connect_started);
+                relay_begin_time = 0;
+            }
+            Metrics::increment("signer_relay_connects_total");
+            Metrics::setGauge("signer_relay_connected", 1);
 
             // Update status display immediately
             displayConnectionStatus(true);
 
-            // Subscribe to NIP-46 events for our device public key
-            if (devicePublicKeyHex.length() > 0)
-            {
-                String subscription = "[\"REQ\", \"signer\", {\"kinds\":[24133], \"#p\":[\"" + devicePublicKeyHex + "\"], \"limit\":0}]";
-                webSocket.sendTXT(subscription);
-                Serial.println("RemoteSigner::websocketEvent() - Sent subscription: " + subscription);
-            }
+            // Without a subscription the link is up but deaf; retried from processLoop()
+            subscription_pending = !sendSubscriptions();
 
             if (status_callback)
             {
@@ -379,6 +503,14 @@ namespace RemoteSigner
 
         case WStype_PONG:
             last_ws_message_received = millis();
+            if (last_ws_ping_sent != 0 && (long)(relay_event_received - last_ws_ping_sent) >= 0)
+            {
+                // Time on the wire only, not time spent waiting in the inbound queue
+                unsigned long rtt = relay_event_received - last_ws_ping_sent;
+                last_ws_ping_sent = 0;
+                Metrics::observe(relay_secure ? "signer_relay_rtt_ms{transport=\"wss\"}" : "signer_relay_rtt_ms{transport=\"ws\"}", rtt);
+                StatusModel::setRelayRtt(rtt);
+            }
             break;
 
         case WStype_ERROR:
@@ -399,14 +531,48 @@ namespace RemoteSigner
 
     void handleWebsocketMessage(void *arg, uint8_t *data, size_t len)
     {
+        TRACE_SCOPE("signer_ws_message");
+        if (len > Config::MAX_FRAME_SIZE)
+        {
+            Serial.println("RemoteSigner::handleWebsocketMessage() - Dropping oversized frame: " + String(len) + " bytes");
+            Metrics::increment("signer_rejected_total{reason=\"frame_size\"}");
+            return;
+        }
+        Metrics::observe("signer_frame_bytes", len);
+
         String message = String((char *)data);
 
-        if (message.indexOf("EVENT") != -1 && message.indexOf("24133") != -1)
+        if (PeerCoordinator::isEnabled() && PeerCoordinator::isPeerMessage(message))
+        {
+            PeerCoordinator::handlePeerMessage(message, devicePublicKeyHex, unixTimestamp > 0 ? timeClient.getEpochTime() : 0);
+        }
+        else if (message.indexOf("EVENT") != -1 && message.indexOf("24133") != -1)
         {
+            if (isStaleRequest(message))
+            {
+                return;
+            }
+
+            // With peers online only the owner of a request answers it
+            if (PeerCoordinator::isEnabled())
+            {
+                String eventId = nostr::getEventId(message);
+                String clientPubKey = nostr::getPubKeyAndContent(message).first;
+                String clientTag = PeerCoordinator::clientTag(devicePrivateKeyHex, clientPubKey);
+                bool authorizedHere = isKnownClient(clientPubKey.c_str());
+                if (!PeerCoordinator::isOwner(eventId, clientTag, authorizedHere))
+                {
+                    Metrics::increment("signer_peer_deferred_total");
+                    PeerCoordinator::deferRequest(eventId, message, clientTag, authorizedHere);
+                    return;
+                }
+            }
+
             long handleWsStartTime = millis();
             Serial.println("RemoteSigner::handleWebsocketMessage() - Received signing request");
             handleSigningRequestEvent(data);
             unsigned long handleWsEndTime = millis();
+            Metrics::observe("signer_request_duration_ms", handleWsEndTime - handleWsStartTime);
             Serial.println("RemoteSigner::handleWebsocketMessage() - Time taken to process message: " + String(handleWsEndTime - handleWsStartTime) + " ms");
         }
         else if (message.indexOf("[\"OK\"") != -1)
@@ -420,88 +586,153 @@ namespace RemoteSigner
         String dataStr = String((char *)data);
         Serial.println("RemoteSigner::handleSigningRequestEvent() - Processing signing request");
 
-        // Extract sender public key from the event using nostr library
-        String requestingPubKey = nostr::getSenderPubKeyHex(dataStr);
+        // Extract sender public key and encrypted content in a single parse
+        auto pubKeyAndContent = nostr::getPubKeyAndContent(dataStr);
+        String requestingPubKey = pubKeyAndContent.first;
+        String content = pubKeyAndContent.second;
         Serial.println("RemoteSigner::handleSigningRequestEvent() - Requesting pubkey: " + requestingPubKey);
 
-        // Determine encryption type (NIP-04 vs NIP-44) and decrypt using device keypair
-        String decryptedMessage = "";
-        if (dataStr.indexOf("?iv=") != -1)
+        if (!isValidPubKeyHex(requestingPubKey))
+        {
+            Serial.println("RemoteSigner::handleSigningRequestEvent() - Invalid sender pubkey");
+            Metrics::increment("signer_rejected_total{reason=\"sender_pubkey\"}");
+            return;
+        }
+
+        // Unknown senders can only be pairing; don't let them monopolise ECDH and decrypt
+        if (!isKnownClient(requestingPubKey.c_str()) && !takeUnknownSenderToken())
+        {
+            Serial.println("RemoteSigner::handleSigningRequestEvent() - Unknown sender rate limit hit, dropping request");
+            Metrics::increment("signer_rejected_total{reason=\"unknown_sender_rate\"}");
+            return;
+        }
+
+        // Peers watch for the tagged reply and drop their parked copy
+        replying_to_event_id = PeerCoordinator::isEnabled() ? nostr::getEventId(dataStr) : "";
+
+        // Detect the scheme on the content; the reply is sent with the same scheme
+        if (nostr::Nip04Scheme::detect(content))
         {
             Serial.println("RemoteSigner::handleSigningRequestEvent() - Using NIP-04 decryption");
-            decryptedMessage = nostr::nip04Decrypt(devicePrivateKeyHex.c_str(), dataStr);
+            processRequest<nostr::Nip04Scheme>(requestingPubKey, content);
         }
         else
         {
             Serial.println("RemoteSigner::handleSigningRequestEvent() - Using NIP-44 decryption");
-            decryptedMessage = nostr::nip44Decrypt(devicePrivateKeyHex.c_str(), dataStr);
+            processRequest<nostr::Nip44Scheme>(requestingPubKey, content);
         }
+        replying_to_event_id = "";
+    }
+
+    template <typename Scheme>
+    void processRequest(const String &requestingPubKey, String &content)
+    {
+        TRACE_SCOPE("signer_process_request");
+        unsigned long decryptStartTime = micros();
+        Trace::begin("signer_decrypt");
+        String decryptedMessage = Scheme::decrypt(devicePrivateKeyHex.c_str(), requestingPubKey, content);
+        Trace::end("signer_decrypt");
+        Metrics::observe("signer_decrypt_duration_us", micros() - decryptStartTime);
 
         if (decryptedMessage.length() == 0)
         {
-            Serial.println("RemoteSigner::handleSigningRequestEvent() - Failed to decrypt message");
+            Serial.println("RemoteSigner::processRequest() - Failed to decrypt message");
+            Metrics::increment("signer_decrypt_failures_total");
             UI::showErrorToast("Message decryption failed");
             return;
         }
 
-        Serial.println("RemoteSigner::handleSigningRequestEvent() - Decrypted message: " + decryptedMessage);
+        Serial.println("RemoteSigner::processRequest() - Decrypted message: " + decryptedMessage);
 
         // Parse the decrypted JSON
-        DeserializationError error = deserializeJson(eventDoc, decryptedMessage);
+        DeserializationError error = deserializeJson(eventDoc, decryptedMessage, DeserializationOption::NestingLimit(Config::MAX_JSON_NESTING));
         if (error)
         {
-            Serial.println("RemoteSigner::handleSigningRequestEvent() - JSON parsing failed: " + String(error.c_str()));
+            Serial.println("RemoteSigner::processRequest() - JSON parsing failed: " + String(error.c_str()));
+            Metrics::increment("signer_parse_failures_total");
             UI::showErrorToast("Invalid request format");
             return;
         }
 
         String method = eventDoc["method"];
-        Serial.println("RemoteSigner::handleSigningRequestEvent() - Method: " + method);
+        Serial.println("RemoteSigner::processRequest() - Method: " + method);
+        Metrics::increment(requestMetricName(method));
+        bool wakeDisplay = !isLoopbackClient(requestingPubKey.c_str());
 
         if (method == Methods::CONNECT)
         {
-            Display::turnOnBacklightForSigning();
-            handleConnect(eventDoc, requestingPubKey);
+            if (wakeDisplay) Display::turnOnBacklightForSigning();
+            handleConnect<Scheme>(eventDoc, requestingPubKey);
         }
         else if (method == Methods::SIGN_EVENT)
         {
-            Display::turnOnBacklightForSigning();
-            handleSignEvent(eventDoc, requestingPubKey.c_str());
+            if (wakeDisplay) Display::turnOnBacklightForSigning();
+            handleSignEvent<Scheme>(eventDoc, requestingPubKey.c_str());
         }
         else if (method == Methods::PING)
         {
-            handlePing(eventDoc, requestingPubKey.c_str());
+            handlePing<Scheme>(eventDoc, requestingPubKey.c_str());
         }
         else if (method == Methods::GET_PUBLIC_KEY)
         {
-            handleGetPublicKey(eventDoc, requestingPubKey.c_str());
+            handleGetPublicKey<Scheme>(eventDoc, requestingPubKey.c_str());
         }
         else if (method == Methods::NIP04_ENCRYPT)
         {
-            Display::turnOnBacklightForSigning();
-            handleNip04Encrypt(eventDoc, requestingPubKey.c_str());
+            if (wakeDisplay) Display::turnOnBacklightForSigning();
+            handleNip04Encrypt<Scheme>(eventDoc, requestingPubKey.c_str());
         }
         else if (method == Methods::NIP04_DECRYPT)
         {
-            Display::turnOnBacklightForSigning();
-            handleNip04Decrypt(eventDoc, requestingPubKey.c_str());
+            if (wakeDisplay) Display::turnOnBacklightForSigning();
+            handleNip04Decrypt<Scheme>(eventDoc, requestingPubKey.c_str());
         }
         else if (method == Methods::NIP44_ENCRYPT)
         {
-            Display::turnOnBacklightForSigning();
-            handleNip44Encrypt(eventDoc, requestingPubKey.c_str());
+            if (wakeDisplay) Display::turnOnBacklightForSigning();
+            handleNip44Encrypt<Scheme>(eventDoc, requestingPubKey.c_str());
         }
         else if (method == Methods::NIP44_DECRYPT)
         {
-            Display::turnOnBacklightForSigning();
-            handleNip44Decrypt(eventDoc, requestingPubKey.c_str());
+            if (wakeDisplay) Display::turnOnBacklightForSigning();
+            handleNip44Decrypt<Scheme>(eventDoc, requestingPubKey.c_str());
         }
         else
         {
-            Serial.println("RemoteSigner::handleSigningRequestEvent() - Unknown method: " + method);
+            Serial.println("RemoteSigner::processRequest() - Unknown method: " + method);
+        }
+    }
+
+    template <typename Scheme>
+    void sendResponse(const char *clientPubKey, const String &responseMsg)
+    {
+        Trace::begin("signer_encrypt_response");
+        String encryptedResponse = nostr::getEncryptedDm<Scheme>(
+            devicePrivateKeyHex.c_str(),
+            devicePublicKeyHex.c_str(),
+            clientPubKey,
+            24133,
+            unixTimestamp,
+            responseMsg,
+            replying_to_event_id);
+        Trace::end("signer_encrypt_response");
+
+        // Loopback replies are built in full but never leave the device
+        if (isLoopbackClient(clientPubKey))
+        {
+            Metrics::increment("signer_loopback_responses_total");
+            return;
+        }
+
+        // Outbound queue full: retried from the in-flight table instead of dropped
+        if (!RelayLink::sendText(encryptedResponse) && !parkResponse(clientPubKey, encryptedResponse))
+        {
+            Serial.println("RemoteSigner::sendResponse() - Outbound queue and in-flight table full, response dropped");
+            Metrics::increment("signer_relay_outbound_dropped_total");
         }
     }
 
+    template <typename Scheme>
     void handleConnect(DynamicJsonDocument &doc, const String &requestingPubKey)
     {
         String requestId = doc["id"];
@@ -511,7 +742,7 @@ namespace RemoteSigner
 
         if (isClientAuthorized(requestingPubKey.c_str()))
         {
-            sendConnectResponse(requestId, secret, requestingPubKey);
+            sendConnectResponse<Scheme>(requestId, secret, requestingPubKey);
             return;
         }
 
@@ -522,13 +753,20 @@ namespace RemoteSigner
         {
             Serial.println("RemoteSigner::handleConnect() - Secret key matches, authorizing client");
             addAuthorizedClient(requestingPubKey.c_str());
-            sendConnectResponse(requestId, secret, requestingPubKey);
+            sendConnectResponse<Scheme>(requestId, secret, requestingPubKey);
             return;
         }
 
-        promptUserForAuthorization(requestingPubKey, requestId, secret);
+#ifdef SIGNER_HEADLESS
+        // Nobody can answer a dialog on a headless signer; pair with the bunker secret
+        Serial.println("RemoteSigner::handleConnect() - Headless build, rejecting client without the bunker secret: " + requestingPubKey);
+        Metrics::increment("signer_connect_rejected_total");
+#else
+        promptUserForAuthorization<Scheme>(requestingPubKey, requestId, secret);
+#endif
     }
 
+    template <typename Scheme>
     void handleSignEvent(DynamicJsonDocument &doc, const char *requestingPubKey)
     {
         String requestId = doc["id"];
@@ -546,7 +784,7 @@ namespace RemoteSigner
         String eventParams = doc["params"][0].as<String>();
 
         // Parse the event data from the first parameter
-        DeserializationError parseError = deserializeJson(eventParamsDoc, eventParams);
+        DeserializationError parseError = deserializeJson(eventParamsDoc, eventParams, DeserializationOption::NestingLimit(Config::MAX_JSON_NESTING));
         if (parseError)
         {
             Serial.println("RemoteSigner::handleSignEvent() - Failed to parse event params: " + String(parseError.c_str()));
@@ -578,6 +816,13 @@ namespace RemoteSigner
             kind,
             tags);
 
+        // Opt-in: publish to the write relays ourselves while the response goes out
+        bool loopback = isLoopbackClient(requestingPubKey);
+        if (!loopback)
+        {
+            RelayPool::eventSigned(signedEvent);
+        }
+
         // Escape quotes in the signed event for JSON response
         signedEvent.replace("\\", "\\\\");
         signedEvent.replace("\"", "\\\"");
@@ -589,21 +834,18 @@ namespace RemoteSigner
         // UI::updateSigningModalText("Broadcasting");
 
         // Encrypt and send response using device keypair for NIP-46 communication
-        String encryptedResponse = nostr::getEncryptedDm(
-            devicePrivateKeyHex.c_str(),
-            devicePublicKeyHex.c_str(),
-            requestingPubKey,
-            24133,
-            unixTimestamp,
-            responseMsg,
-            "nip44");
-
-        webSocket.sendTXT(encryptedResponse);
+        sendResponse<Scheme>(requestingPubKey, responseMsg);
         Serial.println("RemoteSigner::handleSignEvent() - Event signed and response sent");
 
         // Hide signing modal after 250ms delay as requested
         // UI::hideSigningModalDelayed(250);
 
+        // Load runs measure the signing path, not the signed-events list
+        if (loopback)
+        {
+            return;
+        }
+
         // Show notification on device screen
         UI::showEventSignedNotification(String(kind), content);
 
@@ -614,6 +856,7 @@ namespace RemoteSigner
         }
     }
 
+    template <typename Scheme>
     void handlePing(DynamicJsonDocument &doc, const char *requestingPubKey)
     {
         String requestId = doc["id"];
@@ -625,19 +868,11 @@ namespace RemoteSigner
 
         String responseMsg = "{\"id\":\"" + requestId + "\",\"result\":\"pong\"}";
 
-        String encryptedResponse = nostr::getEncryptedDm(
-            devicePrivateKeyHex.c_str(),
-            devicePublicKeyHex.c_str(),
-            requestingPubKey,
-            24133,
-            unixTimestamp,
-            responseMsg,
-            "nip44");
-
-        webSocket.sendTXT(encryptedResponse);
+        sendResponse<Scheme>(requestingPubKey, responseMsg);
         Serial.println("RemoteSigner::handlePing() - Pong sent to: " + String(requestingPubKey));
     }
 
+    template <typename Scheme>
     void handleGetPublicKey(DynamicJsonDocument &doc, const char *requestingPubKey)
     {
         String requestId = doc["id"];
@@ -649,19 +884,11 @@ namespace RemoteSigner
 
         String responseMsg = "{\"id\":\"" + requestId + "\",\"result\":\"" + userPublicKeyHex + "\"}";
 
-        String encryptedResponse = nostr::getEncryptedDm(
-            devicePrivateKeyHex.c_str(),
-            devicePublicKeyHex.c_str(),
-            requestingPubKey,
-            24133,
-            unixTimestamp,
-            responseMsg,
-            "nip44");
-
-        webSocket.sendTXT(encryptedResponse);
+        sendResponse<Scheme>(requestingPubKey, responseMsg);
         Serial.println("RemoteSigner::handleGetPublicKey() - Public key sent to: " + String(requestingPubKey));
     }
 
+    template <typename Scheme>
     void handleNip04Encrypt(DynamicJsonDocument &doc, const char *requestingPubKey)
     {
         if (!isClientAuthorized(requestingPubKey))
@@ -676,19 +903,11 @@ namespace RemoteSigner
         String encryptedMessage = nostr::getCipherText(userPrivateKeyHex.c_str(), thirdPartyPubKey.c_str(), plaintext);
         String responseMsg = "{\"id\":\"" + requestId + "\",\"result\":\"" + encryptedMessage + "\"}";
 
-        String encryptedResponse = nostr::getEncryptedDm(
-            devicePrivateKeyHex.c_str(),
-            devicePublicKeyHex.c_str(),
-            requestingPubKey,
-            24133,
-            unixTimestamp,
-            responseMsg,
-            "nip04");
-
-        webSocket.sendTXT(encryptedResponse);
+        sendResponse<Scheme>(requestingPubKey, responseMsg);
         Serial.println("RemoteSigner::handleNip04Encrypt() - NIP-04 encryption completed");
     }
 
+    template <typename Scheme>
     void handleNip04Decrypt(DynamicJsonDocument &doc, const char *requestingPubKey)
     {
         if (!isClientAuthorized(requestingPubKey))
@@ -703,19 +922,11 @@ namespace RemoteSigner
         String decryptedMessage = nostr::decryptNip04Ciphertext(cipherText, userPrivateKeyHex, thirdPartyPubKey);
         String responseMsg = "{\"id\":\"" + requestId + "\",\"result\":\"" + decryptedMessage + "\"}";
 
-        String encryptedResponse = nostr::getEncryptedDm(
-            devicePrivateKeyHex.c_str(),
-            devicePublicKeyHex.c_str(),
-            requestingPubKey,
-            24133,
-            unixTimestamp,
-            responseMsg,
-            "nip04");
-
-        webSocket.sendTXT(encryptedResponse);
+        sendResponse<Scheme>(requestingPubKey, responseMsg);
         Serial.println("RemoteSigner::handleNip04Decrypt() - NIP-04 decryption completed");
     }
 
+    template <typename Scheme>
     void handleNip44Encrypt(DynamicJsonDocument &doc, const char *requestingPubKey)
     {
         if (!isClientAuthorized(requestingPubKey))
@@ -731,19 +942,11 @@ namespace RemoteSigner
         String encryptedMessage = executeEncryptMessageNip44(plaintext, userPrivateKeyHex, thirdPartyPubKey);
         String responseMsg = "{\"id\":\"" + requestId + "\",\"result\":\"" + encryptedMessage + "\"}";
 
-        String encryptedResponse = nostr::getEncryptedDm(
-            devicePrivateKeyHex.c_str(),
-            devicePublicKeyHex.c_str(),
-            requestingPubKey,
-            24133,
-            unixTimestamp,
-            responseMsg,
-            "nip44");
-
-        webSocket.sendTXT(encryptedResponse);
+        sendResponse<Scheme>(requestingPubKey, responseMsg);
         Serial.println("RemoteSigner::handleNip44Encrypt() - NIP-44 encryption completed");
     }
 
+    template <typename Scheme>
     void handleNip44Decrypt(DynamicJsonDocument &doc, const char *requestingPubKey)
     {
         if (!isClientAuthorized(requestingPubKey))
@@ -759,22 +962,102 @@ namespace RemoteSigner
         String decryptedMessage = executeDecryptMessageNip44(cipherText, userPrivateKeyHex, thirdPartyPubKey);
         String responseMsg = "{\"id\":\"" + requestId + "\",\"result\":\"" + decryptedMessage + "\"}";
 
-        String encryptedResponse = nostr::getEncryptedDm(
-            devicePrivateKeyHex.c_str(),
-            devicePublicKeyHex.c_str(),
-            requestingPubKey,
-            24133,
-            unixTimestamp,
-            responseMsg,
-            "nip44");
-
-        webSocket.sendTXT(encryptedResponse);
+        sendResponse<Scheme>(requestingPubKey, responseMsg);
         Serial.println("RemoteSigner::handleNip44Decrypt() - NIP-44 decryption completed");
     }
 
+    bool isValidPubKeyHex(const String &pubKeyHex)
+    {
+        if (pubKeyHex.length() != 64)
+        {
+            return false;
+        }
+        for (unsigned int i = 0; i < pubKeyHex.length(); i++)
+        {
+            if (!isHexadecimalDigit(pubKeyHex.charAt(i)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool isStaleRequest(const String &message)
+    {
+        // Without a synced clock every request is admitted
+        if (unixTimestamp == 0)
+        {
+            return false;
+        }
+
+        // Only created_at and pubkey are kept, so this costs one scan of the frame
+        StaticJsonDocument<96> filter;
+        filter[0]["created_at"] = true;
+        filter[0]["pubkey"] = true;
+        StaticJsonDocument<320> doc;
+        DeserializationError error = deserializeJson(doc, message, DeserializationOption::Filter(filter), DeserializationOption::NestingLimit(Config::MAX_JSON_NESTING));
+        if (error || !doc[2]["created_at"].is<unsigned long>())
+        {
+            return false; // Left to the full parse to reject
+        }
+
+        // The load generator replays requests built once at the start of a run
+        if (isLoopbackClient(doc[2]["pubkey"] | ""))
+        {
+            return false;
+        }
+
+        unsigned long createdAt = doc[2]["created_at"];
+        unsigned long now = timeClient.getEpochTime();
+        if (createdAt >= now)
+        {
+            return false; // Client clock ahead of ours
+        }
+
+        unsigned long age = now - createdAt;
+        Metrics::observe("signer_request_age_s", age);
+        if (age <= requestTimeoutSeconds)
+        {
+            return false;
+        }
+
+        Serial.println("RemoteSigner::isStaleRequest() - Shedding request created " + String(age) + "s ago (timeout " + String(requestTimeoutSeconds) + "s)");
+        Metrics::increment("signer_shed_total{reason=\"stale\"}");
+        Trace::instant("signer_request_shed");
+        return true;
+    }
+
+    bool takeUnknownSenderToken()
+    {
+        unsigned long now = millis();
+        unsigned long refills = (now - last_token_refill) / Config::UNKNOWN_SENDER_REFILL_MS;
+        if (refills > 0)
+        {
+            unknown_sender_tokens = (int)min((unsigned long)Config::UNKNOWN_SENDER_BURST, unknown_sender_tokens + refills);
+            last_token_refill = now;
+        }
+
+        if (unknown_sender_tokens <= 0)
+        {
+            return false;
+        }
+        unknown_sender_tokens--;
+        return true;
+    }
+
+    static bool isKnownClient(const char *clientPubKey)
+    {
+        return authorizedClients.indexOf(clientPubKey) != -1 || isLoopbackClient(clientPubKey);
+    }
+
+    void setLoopbackClients(const String &clientPubKeys)
+    {
+        loopbackClients = clientPubKeys;
+    }
+
     bool isClientAuthorized(const char *clientPubKey)
     {
-        bool isAuthorised = authorizedClients.indexOf(clientPubKey) != -1;
+        bool isAuthorised = isKnownClient(clientPubKey);
         if (!isAuthorised)
         {
             Serial.println("RemoteSigner::isClientAuthorized() - Client not found in authorized list: " + String(clientPubKey));
@@ -808,15 +1091,193 @@ namespace RemoteSigner
         return false;
     }
 
-    // Structure to store pending authorization request
-    struct PendingAuthRequest {
+    // One NIP-46 request that could not finish when it arrived. Each slot is
+    // a small state machine advanced by processInFlightRequests(); the
+    // generation tells a late dialog callback that its slot was reused.
+    typedef enum {
+        REQUEST_FREE,
+        REQUEST_AWAITING_APPROVAL,
+        REQUEST_APPROVED,
+        REQUEST_DENIED,
+        REQUEST_DISMISSED,                      // Dialog deleted without a choice
+        REQUEST_SENDING
+    } request_state_t;
+
+    struct InFlightRequest {
+        request_state_t state = REQUEST_FREE;
+        uint32_t generation = 0;
         String clientPubKey;
         String requestId;
         String secret;
-        bool isActive = false;
+        String eventId;                         // Request event, tagged on the reply in peer mode
+        String response;                        // REQUEST_SENDING: encrypted reply event
+        void (*resume)(const String &, const String &, const String &) = nullptr; // Approved connect, bound to the request's scheme
+        lv_obj_t *dialog = nullptr;             // Open authorization dialog
+        unsigned long started = 0;
+        unsigned long timeout = 0;
     };
-    static PendingAuthRequest pendingAuth;
+    static InFlightRequest inFlight[Config::MAX_IN_FLIGHT];
+
+    static InFlightRequest *allocateRequest(const char *clientPubKey, unsigned long timeout)
+    {
+        for (int i = 0; i < Config::MAX_IN_FLIGHT; i++)
+        {
+            if (inFlight[i].state == REQUEST_FREE)
+            {
+                InFlightRequest &request = inFlight[i];
+                request.generation++;
+                request.clientPubKey = clientPubKey;
+                request.started = millis();
+                request.timeout = timeout;
+                return &request;
+            }
+        }
+        Serial.println("RemoteSigner::allocateRequest() - " + String(Config::MAX_IN_FLIGHT) + " requests already in flight, rejecting");
+        Metrics::increment("signer_inflight_rejected_total");
+        return nullptr;
+    }
 
+    static void releaseRequest(InFlightRequest &request)
+    {
+        // Bump first so the dialog's delete callback finds a stale generation
+        request.generation++;
+        request.state = REQUEST_FREE;
+        lv_obj_t *dialog = request.dialog;
+        request.dialog = nullptr;
+        UI::closeConfirmationDialog(dialog);
+        request.clientPubKey = "";
+        request.requestId = "";
+        request.secret = "";
+        request.eventId = "";
+        request.response = "";
+        request.resume = nullptr;
+    }
+
+    static int countRequests(request_state_t state)
+    {
+        int count = 0;
+        for (int i = 0; i < Config::MAX_IN_FLIGHT; i++)
+        {
+            if (inFlight[i].state == state)
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    void clearInFlightRequests()
+    {
+        for (int i = 0; i < Config::MAX_IN_FLIGHT; i++)
+        {
+            if (inFlight[i].state != REQUEST_FREE)
+            {
+                releaseRequest(inFlight[i]);
+            }
+        }
+    }
+
+    int getInFlightCount()
+    {
+        return Config::MAX_IN_FLIGHT - countRequests(REQUEST_FREE);
+    }
+
+    bool parkResponse(const char *clientPubKey, const String &encryptedResponse)
+    {
+        InFlightRequest *request = allocateRequest(clientPubKey, requestTimeoutSeconds * 1000UL);
+        if (request == nullptr)
+        {
+            return false;
+        }
+        request->response = encryptedResponse;
+        request->state = REQUEST_SENDING;
+        Serial.println("RemoteSigner::parkResponse() - Outbound queue full, response parked");
+        return true;
+    }
+
+    // Dialog callback; only records the choice, the work happens in processInFlightRequests()
+    static void resumeApproval(int slot, uint32_t generation, UI::dialog_result_t result)
+    {
+        InFlightRequest &request = inFlight[slot];
+        if (request.generation != generation || request.state != REQUEST_AWAITING_APPROVAL)
+        {
+            return;
+        }
+        request.dialog = nullptr; // Deleted by the UI after this returns
+        request.state = result == UI::DIALOG_APPROVED ? REQUEST_APPROVED : (result == UI::DIALOG_DENIED ? REQUEST_DENIED : REQUEST_DISMISSED);
+    }
+
+    void processInFlightRequests()
+    {
+        unsigned long now = millis();
+        for (int i = 0; i < Config::MAX_IN_FLIGHT; i++)
+        {
+            InFlightRequest &request = inFlight[i];
+            switch (request.state)
+            {
+            case REQUEST_FREE:
+                continue;
+
+            case REQUEST_AWAITING_APPROVAL:
+                if (now - request.started >= request.timeout)
+                {
+                    Serial.println("RemoteSigner::processInFlightRequests() - Authorization timed out for: " + request.clientPubKey);
+                    Metrics::increment("signer_inflight_timeouts_total{state=\"approval\"}");
+                    UI::showErrorToast("Client authorization timed out");
+                    releaseRequest(request);
+                }
+                break;
+
+            case REQUEST_APPROVED:
+                Serial.println("RemoteSigner::processInFlightRequests() - User approved client: " + request.clientPubKey);
+                addAuthorizedClient(request.clientPubKey.c_str());
+                Metrics::observe("signer_approval_wait_ms", now - request.started);
+                {
+                    // Copied out: the reply may park itself in a slot of the table
+                    String requestId = request.requestId;
+                    String secret = request.secret;
+                    String clientPubKey = request.clientPubKey;
+                    void (*resume)(const String &, const String &, const String &) = request.resume;
+                    replying_to_event_id = request.eventId;
+                    releaseRequest(request);
+                    resume(requestId, secret, clientPubKey);
+                    replying_to_event_id = "";
+                }
+                break;
+
+            case REQUEST_DENIED:
+                Serial.println("RemoteSigner::processInFlightRequests() - User denied client: " + request.clientPubKey);
+                UI::showErrorToast("Client authorization denied");
+                releaseRequest(request);
+                break;
+
+            case REQUEST_DISMISSED:
+                // Cleared with its screen; the user never answered, so no toast
+                Serial.println("RemoteSigner::processInFlightRequests() - Authorization dialog dismissed for: " + request.clientPubKey);
+                Metrics::increment("signer_inflight_timeouts_total{state=\"dismissed\"}");
+                releaseRequest(request);
+                break;
+
+            case REQUEST_SENDING:
+                // Retried every pass, so only a real send may count as a drop
+                if (RelayLink::hasSendSpace() && RelayLink::sendText(request.response))
+                {
+                    releaseRequest(request);
+                }
+                else if (now - request.started >= request.timeout)
+                {
+                    Serial.println("RemoteSigner::processInFlightRequests() - Dropping response the client has given up on");
+                    Metrics::increment("signer_inflight_timeouts_total{state=\"sending\"}");
+                    Metrics::increment("signer_relay_outbound_dropped_total");
+                    releaseRequest(request);
+                }
+                break;
+            }
+        }
+        Metrics::setGauge("signer_inflight_requests", getInFlightCount());
+    }
+
+    template <typename Scheme>
     void sendConnectResponse(const String &requestId, const String &secret, const String &clientPubKey) {
         // TODO: NDK doesnt support NIP46 responses with result containing the secret.
         // So until NDK fixes this, respond with ack only.
@@ -825,50 +1286,59 @@ namespace RemoteSigner
 
         Serial.println("RemoteSigner::sendConnectResponse() - Sending connect response: " + responseMsg);
 
-        String encryptedResponse = nostr::getEncryptedDm(
-            devicePrivateKeyHex.c_str(),
-            devicePublicKeyHex.c_str(),
-            clientPubKey.c_str(),
-            24133,
-            unixTimestamp,
-            responseMsg,
-            "nip44");
-
-        webSocket.sendTXT(encryptedResponse);
+        sendResponse<Scheme>(clientPubKey.c_str(), responseMsg);
         Serial.println("RemoteSigner::sendConnectResponse() - Response sent");
-        UI::loadScreen(UI::SCREEN_SIGNER_STATUS);
-        UI::showSuccessToast("Client connected");
+
+        // Don't navigate away from the diagnostics screen during a load test,
+        // or clear the dialogs of other clients still waiting for approval
+        if (!isLoopbackClient(clientPubKey.c_str()) && countRequests(REQUEST_AWAITING_APPROVAL) == 0)
+        {
+            UI::loadScreen(UI::SCREEN_SIGNER_STATUS);
+            UI::showSuccessToast("Client connected");
+        }
     }
 
+    template <typename Scheme>
     bool promptUserForAuthorization(const String &requestingNpub, const String &requestId, const String &secret)
     {
         Serial.println("RemoteSigner::promptUserForAuthorization() - Prompting user for: " + requestingNpub);
 
-        // Store pending request
-        pendingAuth.clientPubKey = requestingNpub;
-        pendingAuth.requestId = requestId;
-        pendingAuth.secret = secret;
-        pendingAuth.isActive = true;
+        // A client retrying connect while its dialog is open answers to the latest id
+        for (int i = 0; i < Config::MAX_IN_FLIGHT; i++)
+        {
+            InFlightRequest &pending = inFlight[i];
+            if (pending.state == REQUEST_AWAITING_APPROVAL && pending.clientPubKey == requestingNpub)
+            {
+                pending.requestId = requestId;
+                pending.secret = secret;
+                pending.eventId = replying_to_event_id;
+                pending.resume = &sendConnectResponse<Scheme>;
+                return false;
+            }
+        }
+
+        InFlightRequest *request = allocateRequest(requestingNpub.c_str(), Config::APPROVAL_TIMEOUT_MS);
+        if (request == nullptr)
+        {
+            UI::showErrorToast("Too many pending requests");
+            return false;
+        }
+        request->requestId = requestId;
+        request->secret = secret;
+        request->eventId = replying_to_event_id;
+        request->resume = &sendConnectResponse<Scheme>;
+        request->state = REQUEST_AWAITING_APPROVAL;
 
         // Show user confirmation dialog
         String truncatedPubkey = requestingNpub.substring(0, 16) + "...";
         String message = "Allow client to connect?\n\nClient: " + truncatedPubkey;
-        
-        UI::showConfirmationDialog("Client Authorization", message, [](bool approved) {
-            if (!pendingAuth.isActive) return;
-            
-            if (approved) {
-                addAuthorizedClient(pendingAuth.clientPubKey.c_str());
-                sendConnectResponse(pendingAuth.requestId, pendingAuth.secret, pendingAuth.clientPubKey);
-                Serial.println("RemoteSigner::promptUserForAuthorization() - User approved client: " + pendingAuth.clientPubKey);
-            } else {
-                UI::showErrorToast("Client authorization denied");
-                Serial.println("RemoteSigner::promptUserForAuthorization() - User denied client: " + pendingAuth.clientPubKey);
-            }
-            
-            pendingAuth.isActive = false;
+
+        int slot = request - inFlight;
+        uint32_t generation = request->generation;
+        request->dialog = UI::showConfirmationDialog("Client Authorization", message, [slot, generation](UI::dialog_result_t result) {
+            resumeApproval(slot, generation, result);
         });
-        
+
         // Return false since we're handling this asynchronously
         return false;
     }
@@ -893,11 +1363,25 @@ namespace RemoteSigner
             }
             authorizedClients += clientPubKey;
             saveConfigToPreferences();
+            publishClientCount();
+
+            // Ahead of the reply, so peers route the client's next request here
+            if (PeerCoordinator::isEnabled())
+            {
+                sendHeartbeat();
+            }
             Serial.println("RemoteSigner::addAuthorizedClient() - Client authorized: " + String(clientPubKey));
             Serial.println("Total authorized clients: " + String(getAuthorizedClientCount()));
         }
     }
 
+    static void publishClientCount()
+    {
+        int count = getAuthorizedClientCount();
+        Metrics::setGauge("signer_authorized_clients", count);
+        StatusModel::setClientCount(count);
+    }
+
     int getAuthorizedClientCount()
     {
         if (authorizedClients.length() == 0)
@@ -984,10 +1468,10 @@ namespace RemoteSigner
     {
         authorizedClients = "";
         saveConfigToPreferences();
+        publishClientCount();
         Serial.println("RemoteSigner::clearAllAuthorizedClients() - All authorized clients cleared");
     }
 
-    unsigned long wsLoopCounter = 0;
     void processLoop()
     {
         if (!signer_initialized || WiFiManager::isBackgroundOperationsPaused())
@@ -995,6 +1479,20 @@ namespace RemoteSigner
             return;
         }
 
+        // Frames and connection events received by the RelayLink task
+        RelayLink::Event event;
+        for (int i = 0; i < Config::MAX_RELAY_EVENTS_PER_LOOP && RelayLink::takeEvent(event); i++)
+        {
+            Metrics::observe("signer_relay_inbound_wait_ms", millis() - event.received);
+            relay_event_received = event.received;
+            relay_connect_started = event.connectStarted;
+            websocketEvent(event.type, event.payload, event.length);
+            RelayLink::releaseEvent(event);
+        }
+
+        // Approvals, timeouts and parked responses
+        processInFlightRequests();
+
         // Only update time and process WebSocket if WiFi is connected
         if (WiFiManager::isConnected())
         {
@@ -1007,15 +1505,21 @@ namespace RemoteSigner
                 lastTimeUpdate = now;
             }
 
-            // Process WebSocket events
-            webSocket.loop();
-            // Serial.println("WS loop iteration: " + String(wsLoopCounter++));
+            if (subscription_pending && isConnected() && RelayLink::hasSendSpace())
+            {
+                subscription_pending = !sendSubscriptions();
+            }
 
             if (now - last_ws_ping > Config::WS_PING_INTERVAL)
             {
                 sendPing();
                 last_ws_ping = now;
             }
+
+            if (PeerCoordinator::isEnabled() && isConnected())
+            {
+                processPeers();
+            }
         }
 
         unsigned long now = millis();
@@ -1092,11 +1596,78 @@ namespace RemoteSigner
         }
     }
 
+    static void sendHeartbeat()
+    {
+        // Not retried; the next one is due within the heartbeat interval
+        if (unixTimestamp > 0 && !RelayLink::sendText(PeerCoordinator::buildHeartbeat(devicePrivateKeyHex, devicePublicKeyHex, unixTimestamp, authorizedClients)))
+        {
+            Metrics::increment("signer_relay_outbound_dropped_total");
+        }
+    }
+
+    // NIP-46 requests for our device key, plus heartbeats and replies from peers
+    static bool sendSubscriptions()
+    {
+        if (devicePublicKeyHex.length() == 0)
+        {
+            return true;
+        }
+
+        // Relays that ignore limit:0 would otherwise replay requests already timed out
+        String since = "";
+        if (unixTimestamp > 0)
+        {
+            since = ", \"since\":" + String(timeClient.getEpochTime() - requestTimeoutSeconds);
+        }
+        String subscription = "[\"REQ\", \"signer\", {\"kinds\":[24133], \"#p\":[\"" + devicePublicKeyHex + "\"], \"limit\":0" + since + "}]";
+        if (!RelayLink::sendText(subscription))
+        {
+            Serial.println("RemoteSigner::sendSubscriptions() - Outbound queue full, subscription will be retried");
+            return false;
+        }
+        Serial.println("RemoteSigner::sendSubscriptions() - Sent subscription: " + subscription);
+
+        // A retry resends both REQs; relays replace a subscription with the same id
+        if (PeerCoordinator::isEnabled() && !RelayLink::sendText(PeerCoordinator::buildSubscription(devicePublicKeyHex)))
+        {
+            Serial.println("RemoteSigner::sendSubscriptions() - Outbound queue full, peer subscription will be retried");
+            return false;
+        }
+        return true;
+    }
+
+    void processPeers()
+    {
+        if (PeerCoordinator::isHeartbeatDue())
+        {
+            sendHeartbeat();
+        }
+
+        PeerCoordinator::pruneExpired();
+
+        // Answer requests whose owner stopped heartbeating
+        String rawMessage;
+        while (PeerCoordinator::takeReassignedRequest(rawMessage))
+        {
+            if (isStaleRequest(rawMessage))
+            {
+                continue;
+            }
+            Metrics::increment("signer_peer_takeovers_total");
+            handleSigningRequestEvent((uint8_t *)rawMessage.c_str());
+        }
+    }
+
     void sendPing()
     {
         if (isConnected())
         {
-            webSocket.sendPing();
+            if (!RelayLink::sendPing())
+            {
+                Metrics::increment("signer_relay_outbound_dropped_total");
+                return;
+            }
+            last_ws_ping_sent = millis();
         }
     }
 
@@ -1107,7 +1678,7 @@ namespace RemoteSigner
 
     bool isConnected()
     {
-        return webSocket.isConnected();
+        return RelayLink::isConnected();
     }
 
     unsigned long getUnixTimestamp()
@@ -1127,55 +1698,75 @@ namespace RemoteSigner
 
     void displayConnectionStatus(bool connected)
     {
-        if (status_label && lv_obj_is_valid(status_label))
-        {
-            String statusText;
-            uint32_t statusColor;
-
-            if (connected)
-            {
-                statusText = "Relay: Connected";
-                statusColor = 0x00FF00; // Green
-            }
-            else if (connection_in_progress)
-            {
-                statusText = "Relay: Connecting...";
-                statusColor = 0xFFA500; // Orange
-            }
-            else if (manual_reconnect_needed && reconnection_attempts > 0)
-            {
-                statusText = "Relay: Reconnecting (" + String(reconnection_attempts) + "/" + String(Config::MAX_RECONNECT_ATTEMPTS) + ")";
-                statusColor = 0xFFA500; // Orange
-            }
-            else if (reconnection_attempts >= Config::MAX_RECONNECT_ATTEMPTS)
-            {
-                statusText = "Relay: Failed";
-                statusColor = 0xFF0000; // Red
-            }
-            else
-            {
-                statusText = "Relay: Disconnected";
-                statusColor = 0x9E9E9E; // Grey
-            }
+        String statusText;
+        uint32_t statusColor;
 
-            lv_label_set_text(status_label, statusText.c_str());
-            lv_obj_set_style_text_color(status_label, lv_color_hex(statusColor), 0);
+        if (connected)
+        {
+            statusText = "Relay: Connected";
+            statusColor = 0x00FF00; // Green
+        }
+        else if (connection_in_progress)
+        {
+            statusText = "Relay: Connecting...";
+            statusColor = 0xFFA500; // Orange
         }
+        else if (manual_reconnect_needed && reconnection_attempts > 0)
+        {
+            statusText = "Relay: Reconnecting (" + String(reconnection_attempts) + "/" + String(Config::MAX_RECONNECT_ATTEMPTS) + ")";
+            statusColor = 0xFFA500; // Orange
+        }
+        else if (reconnection_attempts >= Config::MAX_RECONNECT_ATTEMPTS)
+        {
+            statusText = "Relay: Failed";
+            statusColor = 0xFF0000; // Red
+        }
+        else
+        {
+            statusText = "Relay: Disconnected";
+            statusColor = 0x9E9E9E; // Grey
+        }
+
+        StatusModel::setRelayStatus(statusText, statusColor);
     }
 
     // Getters
     String getRelayUrl() { return relayUrl; }
     void setRelayUrl(const String &url) { relayUrl = url; }
+    String getPlaintextAllowList() { return plaintextAllowList; }
+
+    void setPlaintextAllowList(const String &allowList)
+    {
+        plaintextAllowList = allowList;
+        plaintextAllowList.trim();
+
+        Preferences prefs;
+        if (prefs.begin("signer", false))
+        {
+            prefs.putString("ws_allow", plaintextAllowList);
+            prefs.end();
+        }
+        Serial.println("RemoteSigner::setPlaintextAllowList() - ws:// allowed for: " + (plaintextAllowList.length() > 0 ? plaintextAllowList : String("(none)")));
+    }
+    unsigned long getRequestTimeout() { return requestTimeoutSeconds; }
+
+    void setRequestTimeout(unsigned long seconds)
+    {
+        requestTimeoutSeconds = constrain(seconds, Config::MIN_REQUEST_TIMEOUT_S, Config::MAX_REQUEST_TIMEOUT_S);
+
+        Preferences prefs;
+        if (prefs.begin("signer", false))
+        {
+            prefs.putULong("req_timeout", requestTimeoutSeconds);
+            prefs.end();
+        }
+        Serial.println("RemoteSigner::setRequestTimeout() - Shedding requests older than " + String(requestTimeoutSeconds) + "s");
+    }
+
     // Legacy compatibility functions (map to user keypair)
     String getPrivateKey() { return userPrivateKeyHex; }
     void setPrivateKey(const String &privKeyHex) { setUserPrivateKey(privKeyHex); }
     String getPublicKey() { return userPublicKeyHex; }
-    void setStatusLabel(lv_obj_t *label)
-    {
-        status_label = label;
-        // Update status immediately after setting the label
-        displayConnectionStatus(isConnected());
-    }
 
     // New keypair management functions
     void generateDeviceKeypair()
@@ -1235,4 +1826,41 @@ namespace RemoteSigner
     }
     String getUserPublicKey() { return userPublicKeyHex; }
     String getDevicePublicKey() { return devicePublicKeyHex; }
+
+    bool importDeviceKeypair(const String &privKeyHex)
+    {
+        if (privKeyHex.length() != 64)
+        {
+            return false;
+        }
+
+        try
+        {
+            int byteSize = 32;
+            byte privateKeyBytes[byteSize];
+            fromHex(privKeyHex, privateKeyBytes, byteSize);
+            PrivateKey privKey(privateKeyBytes);
+            PublicKey pub = privKey.publicKey();
+            devicePrivateKeyHex = privKeyHex;
+            devicePublicKeyHex = pub.toString().substring(2);
+        }
+        catch (...)
+        {
+            Serial.println("RemoteSigner: ERROR - Failed to derive imported device public key");
+            return false;
+        }
+
+        Preferences prefs;
+        if (!prefs.begin("signer", false))
+        {
+            Serial.println("RemoteSigner::importDeviceKeypair() - Failed to open preferences");
+            return false;
+        }
+        prefs.putString("dev_priv_key", devicePrivateKeyHex);
+        prefs.putString("dev_pub_key", devicePublicKeyHex);
+        prefs.end();
+
+        Serial.println("RemoteSigner::importDeviceKeypair() - Shared device key imported, public key: " + devicePublicKeyHex);
+        return true;
+    }
 }
\ No newline at end of file
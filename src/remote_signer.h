@@ -23,14 +23,19 @@ namespace RemoteSigner {
     void saveConfigToPreferences();
     String getRelayUrl();
     void setRelayUrl(const String& url);
+    String getPlaintextAllowList();
+    void setPlaintextAllowList(const String& allowList); // Persisted; see RelayUrl::isPlaintextAllowed()
+    unsigned long getRequestTimeout();
+    void setRequestTimeout(unsigned long seconds);       // Persisted; requests older than this are shed
     
     // User keypair management (for signing events)
     String getUserPrivateKey();
     void setUserPrivateKey(const String& privKeyHex);
     String getUserPublicKey();
     
-    // Device keypair management (for NIP-46 communication, read-only)
+    // Device keypair management (for NIP-46 communication)
     String getDevicePublicKey();
+    bool importDeviceKeypair(const String& privKeyHex); // Shared key for signer pairs
     
     // Legacy compatibility (maps to user keypair)
     String getPrivateKey();
@@ -44,27 +49,42 @@ namespace RemoteSigner {
     void removeOldestClient();
     void removeHalfClients();
     
-    // WebSocket event handling
+    // WebSocket event handling, on the loop task for events queued by RelayLink
     void websocketEvent(WStype_t type, uint8_t* payload, size_t length);
     void handleWebsocketMessage(void* arg, uint8_t* data, size_t len);
     void resetWebsocketFragmentState();
     
-    // NIP-46 protocol handlers
+    // NIP-46 protocol handlers. Scheme is the envelope scheme the request
+    // arrived in (nostr::Nip04Scheme or nostr::Nip44Scheme, see
+    // lib/nostr/envelope.h) and is reused for the reply.
     void handleSigningRequestEvent(uint8_t* data);
-    void handleConnect(DynamicJsonDocument& doc, const String& requestingPubKey);
-    void handleSignEvent(DynamicJsonDocument& doc, const char* requestingPubKey);
-    void handlePing(DynamicJsonDocument& doc, const char* requestingPubKey);
-    void handleGetPublicKey(DynamicJsonDocument& doc, const char* requestingPubKey);
-    void handleNip04Encrypt(DynamicJsonDocument& doc, const char* requestingPubKey);
-    void handleNip04Decrypt(DynamicJsonDocument& doc, const char* requestingPubKey);
-    void handleNip44Encrypt(DynamicJsonDocument& doc, const char* requestingPubKey);
-    void handleNip44Decrypt(DynamicJsonDocument& doc, const char* requestingPubKey);
+    template <typename Scheme> void processRequest(const String& requestingPubKey, String& content);
+    template <typename Scheme> void sendResponse(const char* clientPubKey, const String& responseMsg);
+    template <typename Scheme> void handleConnect(DynamicJsonDocument& doc, const String& requestingPubKey);
+    template <typename Scheme> void handleSignEvent(DynamicJsonDocument& doc, const char* requestingPubKey);
+    template <typename Scheme> void handlePing(DynamicJsonDocument& doc, const char* requestingPubKey);
+    template <typename Scheme> void handleGetPublicKey(DynamicJsonDocument& doc, const char* requestingPubKey);
+    template <typename Scheme> void handleNip04Encrypt(DynamicJsonDocument& doc, const char* requestingPubKey);
+    template <typename Scheme> void handleNip04Decrypt(DynamicJsonDocument& doc, const char* requestingPubKey);
+    template <typename Scheme> void handleNip44Encrypt(DynamicJsonDocument& doc, const char* requestingPubKey);
+    template <typename Scheme> void handleNip44Decrypt(DynamicJsonDocument& doc, const char* requestingPubKey);
 
-    void sendConnectResponse(const String& requestId, const String& secret, const String& requestingPubKey);
+    template <typename Scheme> void sendConnectResponse(const String& requestId, const String& secret, const String& requestingPubKey);
     
     // Client authorization management
     bool isClientAuthorized(const char* clientPubKey);
-    bool promptUserForAuthorization(const String& requestingNpub, const String& requestId, const String& secret);
+    bool isValidPubKeyHex(const String& pubKeyHex);
+    bool takeUnknownSenderToken();
+    bool isStaleRequest(const String& message);
+    void setLoopbackClients(const String& clientPubKeys); // '|'-separated, "" to clear
+    template <typename Scheme> bool promptUserForAuthorization(const String& requestingNpub, const String& requestId, const String& secret);
+
+    // In-flight requests: each waits for approval or outbound space in its
+    // own slot and is advanced by processInFlightRequests() without blocking others
+    void processInFlightRequests();
+    void clearInFlightRequests();
+    int getInFlightCount();
+    bool parkResponse(const char* clientPubKey, const String& encryptedResponse);
     void addAuthorizedClient(const char* clientPubKey);
     bool checkClientIsAuthorized(const char* clientPubKey, const char* secret);
     void clearAllAuthorizedClients();
@@ -79,6 +99,7 @@ namespace RemoteSigner {
     
     // Connection monitoring
     void processLoop();
+    void processPeers();
     void sendPing();
     void updateConnectionStatus();
     
@@ -93,8 +114,7 @@ namespace RemoteSigner {
     typedef void (*signer_status_callback_t)(bool connected, const String& status);
     void setStatusCallback(signer_status_callback_t callback);
     
-    // UI integration
-    void setStatusLabel(lv_obj_t* label);
+    // UI integration (status is published to StatusModel)
     void displaySigningRequest(const String& eventKind, const String& content);
     void displayConnectionStatus(bool connected);
     
@@ -109,6 +129,23 @@ namespace RemoteSigner {
         const unsigned long CONNECTION_TIMEOUT = 30000;
         const int MAX_RECONNECT_ATTEMPTS = 10;
         const unsigned long MIN_RECONNECT_INTERVAL = 5000;
+        const int MAX_RELAY_EVENTS_PER_LOOP = 4;          // Inbound frames handled per processLoop() call
+
+        // Bounds on untrusted relay input
+        const size_t MAX_FRAME_SIZE = 96 * 1024;          // Largest NIP-44 payload plus event envelope
+        const uint8_t MAX_JSON_NESTING = 4;               // Decrypted requests and events to sign
+        const int UNKNOWN_SENDER_BURST = 5;               // Decrypts allowed for unauthorized senders...
+        const unsigned long UNKNOWN_SENDER_REFILL_MS = 1000; // ...refilled one per interval
+
+        // Deadline-aware admission: requests the client has given up on are
+        // dropped before any crypto, so a backlog cannot delay live ones
+        const unsigned long DEFAULT_REQUEST_TIMEOUT_S = 30;  // Typical NIP-46 client timeout
+        const unsigned long MIN_REQUEST_TIMEOUT_S = 5;
+        const unsigned long MAX_REQUEST_TIMEOUT_S = 600;
+
+        // Requests parked waiting for the user or the outbound queue
+        const int MAX_IN_FLIGHT = 8;
+        const unsigned long APPROVAL_TIMEOUT_MS = 120000;   // Authorization dialogs close after this
     }
     
     // NIP-46 Methods
@@ -0,0 +1,126 @@
+#include "status_model.h"
+#include "metrics.h"
+
+namespace StatusModel {
+    struct FieldValue {
+        String text;
+        uint32_t color = 0xFFFFFF;
+        bool hasColor = false;
+    };
+
+    struct Binding {
+        lv_obj_t* label = nullptr;
+        field_t field = FIELD_WIFI_STATUS;
+        bool hideWhenEmpty = false;
+    };
+
+    static FieldValue values[FIELD_COUNT];
+    static Binding bindings[Config::MAX_BINDINGS];
+
+    static void applyText(const Binding& binding, const FieldValue& value) {
+        lv_label_set_text(binding.label, value.text.c_str());
+        if (binding.hideWhenEmpty) {
+            if (value.text.length() == 0) {
+                lv_obj_add_flag(binding.label, LV_OBJ_FLAG_HIDDEN);
+            } else {
+                lv_obj_clear_flag(binding.label, LV_OBJ_FLAG_HIDDEN);
+            }
+        }
+    }
+
+    static void applyColor(const Binding& binding, const FieldValue& value) {
+        if (value.hasColor) {
+            lv_obj_set_style_text_color(binding.label, lv_color_hex(value.color), 0);
+        }
+    }
+
+    static void publish(field_t field, const String& text, uint32_t color, bool hasColor) {
+        FieldValue& value = values[field];
+        bool textChanged = value.text != text;
+        bool colorChanged = hasColor && (!value.hasColor || value.color != color);
+
+        if (!textChanged && !colorChanged) {
+            Metrics::increment("ui_status_updates_skipped_total");
+            return;
+        }
+
+        value.text = text;
+        if (hasColor) {
+            value.color = color;
+            value.hasColor = true;
+        }
+        Metrics::increment("ui_status_updates_total");
+
+        for (int i = 0; i < Config::MAX_BINDINGS; i++) {
+            const Binding& binding = bindings[i];
+            if (binding.label == nullptr || binding.field != field) {
+                continue;
+            }
+            if (textChanged) {
+                applyText(binding, value);
+            }
+            if (colorChanged) {
+                applyColor(binding, value);
+            }
+        }
+    }
+
+    void setWifiStatus(const String& text, uint32_t color) {
+        publish(FIELD_WIFI_STATUS, text, color, true);
+    }
+
+    void setWifiConnectProgress(const String& text) {
+        publish(FIELD_WIFI_CONNECT_PROGRESS, text, 0, false);
+    }
+
+    void setRelayStatus(const String& text, uint32_t color) {
+        publish(FIELD_RELAY_STATUS, text, color, true);
+    }
+
+    void setRssi(int rssi) {
+        publish(FIELD_RSSI, rssi == 0 ? String("") : String(rssi) + " dBm", 0, false);
+    }
+
+    void setRelayRtt(uint32_t rttMs) {
+        publish(FIELD_RELAY_RTT, "RTT " + String(rttMs) + " ms", 0, false);
+    }
+
+    void setClientCount(int count) {
+        publish(FIELD_CLIENT_COUNT, String(count) + (count == 1 ? " client" : " clients"), 0, false);
+    }
+
+    void setLastSignedEvent(const String& summary) {
+        publish(FIELD_LAST_SIGNED_EVENT, "Last signed: " + summary, 0, false);
+    }
+
+    static void labelDeletedCB(lv_event_t* e) {
+        lv_obj_t* label = lv_event_get_target(e);
+        for (int i = 0; i < Config::MAX_BINDINGS; i++) {
+            if (bindings[i].label == label) {
+                bindings[i].label = nullptr;
+            }
+        }
+    }
+
+    void bindLabel(lv_obj_t* label, field_t field, bool hideWhenEmpty) {
+        if (label == nullptr) {
+            return;
+        }
+
+        for (int i = 0; i < Config::MAX_BINDINGS; i++) {
+            if (bindings[i].label != nullptr) {
+                continue;
+            }
+            bindings[i].label = label;
+            bindings[i].field = field;
+            bindings[i].hideWhenEmpty = hideWhenEmpty;
+            lv_obj_add_event_cb(label, labelDeletedCB, LV_EVENT_DELETE, NULL);
+
+            // Show the current value straight away
+            applyText(bindings[i], values[field]);
+            applyColor(bindings[i], values[field]);
+            return;
+        }
+        Serial.println("StatusModel::bindLabel() - No free binding slots");
+    }
+}
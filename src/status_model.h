@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+/**
+ * Observable status shown across screens.
+ *
+ * Modules publish values here instead of writing LVGL objects; the UI binds
+ * labels to fields. A setter only touches bound labels when the formatted
+ * text or colour actually differs from what is already shown, so periodic
+ * publishers do not invalidate and redraw unchanged widgets.
+ */
+namespace StatusModel {
+    typedef enum {
+        FIELD_WIFI_STATUS,
+        FIELD_WIFI_CONNECT_PROGRESS,
+        FIELD_RELAY_STATUS,
+        FIELD_RSSI,
+        FIELD_RELAY_RTT,
+        FIELD_CLIENT_COUNT,
+        FIELD_LAST_SIGNED_EVENT,
+        FIELD_COUNT
+    } field_t;
+
+    // Publishers
+    void setWifiStatus(const String& text, uint32_t color);
+    void setWifiConnectProgress(const String& text);
+    void setRelayStatus(const String& text, uint32_t color);
+    void setRssi(int rssi);            // 0 when not associated
+    void setRelayRtt(uint32_t rttMs);
+    void setClientCount(int count);
+    void setLastSignedEvent(const String& summary);
+
+    // Bindings; cleared automatically when the label is deleted
+    void bindLabel(lv_obj_t* label, field_t field, bool hideWhenEmpty = false);
+
+    namespace Config {
+        const int MAX_BINDINGS = 16;
+    }
+}
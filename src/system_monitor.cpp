@@ -0,0 +1,316 @@
+#include "system_monitor.h"
+#include "metrics.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_freertos_hooks.h>
+
+namespace SystemMonitor {
+    struct TaskSample {
+        char name[configMAX_TASK_NAME_LEN];
+        TaskHandle_t handle = nullptr;
+        int core = -1;              // -1 when the task may run on either core
+        uint32_t stackFree = 0;     // Bytes never used since the task started
+        uint32_t runTime = 0;       // Run-time counter at the last sample
+        uint8_t cpuPercent = 0;     // Share of one core since the previous sample
+    };
+
+    static TaskSample tasks[Config::MAX_TASKS];
+    static int task_count = 0;
+    static int core_percent[portNUM_PROCESSORS] = {0};
+    static bool have_cpu_stats = false;         // Per task, needs configGENERATE_RUN_TIME_STATS
+    static bool have_core_stats = false;        // Per core, from run-time stats or the idle hooks
+    static uint32_t last_total_run_time = 0;
+    static unsigned long last_sample = 0;
+
+    // Idle hook wakeups per core. Each call is one pass of the idle task,
+    // which then waits for the next interrupt, so a fully idle core sees
+    // about one call per tick.
+    static volatile uint32_t idle_calls[portNUM_PROCESSORS] = {0};
+    static uint32_t last_idle_calls[portNUM_PROCESSORS] = {0};
+    static uint32_t last_idle_sample = 0;
+    static bool idle_hooks_registered = false;
+
+    static bool idleHookCore0() {
+        idle_calls[0]++;
+        return true;
+    }
+
+#if portNUM_PROCESSORS > 1
+    static bool idleHookCore1() {
+        idle_calls[1]++;
+        return true;
+    }
+#endif
+
+    static uint32_t last_loop_micros = 0;
+    static uint32_t average_period = 0;     // Running average loop period in micros
+    static uint32_t jitter_buckets[Config::JITTER_BUCKET_COUNT] = {0};
+    static uint32_t jitter_count = 0;
+    static uint64_t jitter_sum_ms = 0;
+    static uint32_t jitter_alerts = 0;
+    static unsigned long last_alert_log = 0;
+
+    static int jitterBucket(uint32_t jitterMs) {
+        uint32_t bound = 1;
+        for (int i = 0; i < Config::JITTER_BUCKET_COUNT - 1; i++) {
+            if (jitterMs <= bound) {
+                return i;
+            }
+            bound *= 2;
+        }
+        return Config::JITTER_BUCKET_COUNT - 1;
+    }
+
+    // Upper bound in ms of the bucket holding the given percentile, -1 for +Inf
+    static int jitterPercentile(int percentile) {
+        uint32_t rank = (jitter_count * percentile + 99) / 100;
+        uint32_t seen = 0;
+        for (int i = 0; i < Config::JITTER_BUCKET_COUNT; i++) {
+            seen += jitter_buckets[i];
+            if (seen >= rank) {
+                return i == Config::JITTER_BUCKET_COUNT - 1 ? -1 : (1 << i);
+            }
+        }
+        return -1;
+    }
+
+    static void recordLoopPeriod() {
+        uint32_t now = micros();
+        if (last_loop_micros == 0) {
+            last_loop_micros = now;
+            return;
+        }
+
+        uint32_t period = now - last_loop_micros;
+        last_loop_micros = now;
+        static const Metrics::Handle loop_period_metric = Metrics::summary("signer_loop_period_us");
+        Metrics::observe(loop_period_metric, period);
+
+        if (average_period == 0) {
+            average_period = period;
+        }
+        uint32_t jitter = period > average_period ? period - average_period : average_period - period;
+        average_period = (average_period * 15 + period) / 16;
+
+        uint32_t jitterMs = jitter / 1000;
+        jitter_buckets[jitterBucket(jitterMs)]++;
+        jitter_count++;
+        jitter_sum_ms += jitterMs;
+
+        if (jitterMs > Config::JITTER_ALERT_MS) {
+            jitter_alerts++;
+            Metrics::increment("signer_loop_jitter_alerts_total");
+            if (millis() - last_alert_log >= Config::ALERT_LOG_INTERVAL) {
+                last_alert_log = millis();
+                Serial.println("SystemMonitor::processLoop() - WARNING: loop period " + String(period / 1000) + " ms, " + String(jitterMs) + " ms off the " + String(average_period / 1000) + " ms average");
+            }
+        }
+    }
+
+    static void registerIdleHooks() {
+        idle_hooks_registered = true;
+        if (esp_register_freertos_idle_hook_for_cpu(idleHookCore0, 0) != ESP_OK) {
+            Serial.println("SystemMonitor::registerIdleHooks() - Could not register the core 0 idle hook");
+            idle_hooks_registered = false;
+        }
+#if portNUM_PROCESSORS > 1
+        if (esp_register_freertos_idle_hook_for_cpu(idleHookCore1, 1) != ESP_OK) {
+            Serial.println("SystemMonitor::registerIdleHooks() - Could not register the core 1 idle hook");
+            idle_hooks_registered = false;
+        }
+#endif
+        last_idle_sample = micros();
+    }
+
+    // Per-core load when the core is built without run-time stats. Tick
+    // resolution only; extra interrupt wakeups are clamped at fully idle.
+    static void sampleIdleHooks() {
+        uint32_t now = micros();
+        uint32_t elapsed = now - last_idle_sample;
+        last_idle_sample = now;
+        if (!idle_hooks_registered || elapsed == 0) {
+            return;
+        }
+
+        uint64_t expected = (uint64_t)configTICK_RATE_HZ * elapsed / 1000000;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            uint32_t calls = idle_calls[core];
+            uint32_t idle = calls - last_idle_calls[core];
+            last_idle_calls[core] = calls;
+            core_percent[core] = expected == 0 ? 0 : 100 - (int)min((uint64_t)100, (uint64_t)idle * 100 / expected);
+        }
+        have_core_stats = true;
+    }
+
+    static void sampleTasks() {
+#if configUSE_TRACE_FACILITY
+        static TaskStatus_t status[Config::MAX_TASKS];
+        uint32_t totalRunTime = 0;
+        UBaseType_t count = uxTaskGetSystemState(status, Config::MAX_TASKS, &totalRunTime);
+        if (count == 0) {
+            Serial.println("SystemMonitor::sampleTasks() - More than " + String(Config::MAX_TASKS) + " tasks, skipping sample");
+            return;
+        }
+
+        // Run-time counters are only maintained with configGENERATE_RUN_TIME_STATS
+        uint32_t elapsed = totalRunTime - last_total_run_time;
+        bool haveDelta = totalRunTime != 0 && last_total_run_time != 0 && elapsed > 0;
+        last_total_run_time = totalRunTime;
+
+        static TaskSample previous[Config::MAX_TASKS];
+        int previousCount = task_count;
+        memcpy(previous, tasks, sizeof(TaskSample) * previousCount);
+
+        task_count = count;
+        for (int i = 0; i < task_count; i++) {
+            TaskSample& sample = tasks[i];
+            strlcpy(sample.name, status[i].pcTaskName, sizeof(sample.name));
+            sample.handle = status[i].xHandle;
+            BaseType_t affinity = xTaskGetAffinity(status[i].xHandle);
+            sample.core = affinity == tskNO_AFFINITY ? -1 : affinity;
+            sample.stackFree = status[i].usStackHighWaterMark;
+            sample.runTime = status[i].ulRunTimeCounter;
+            sample.cpuPercent = 0;
+
+            if (!haveDelta) {
+                continue;
+            }
+            for (int j = 0; j < previousCount; j++) {
+                if (previous[j].handle == sample.handle) {
+                    uint32_t used = sample.runTime - previous[j].runTime;
+                    sample.cpuPercent = min((uint64_t)100, (uint64_t)used * 100 / elapsed);
+                    break;
+                }
+            }
+        }
+
+        have_cpu_stats = haveDelta;
+        if (!have_cpu_stats) {
+            return;
+        }
+        have_core_stats = true;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            TaskHandle_t idle = xTaskGetIdleTaskHandleForCPU(core);
+            for (int i = 0; i < task_count; i++) {
+                if (tasks[i].handle == idle) {
+                    core_percent[core] = 100 - tasks[i].cpuPercent;
+                    break;
+                }
+            }
+        }
+#endif
+    }
+
+    void processLoop() {
+        recordLoopPeriod();
+
+        if (millis() - last_sample >= Config::SAMPLE_INTERVAL) {
+            last_sample = millis();
+            sampleTasks();
+            if (!have_cpu_stats) {
+                if (!idle_hooks_registered) {
+                    registerIdleHooks();
+                } else {
+                    sampleIdleHooks();
+                }
+            }
+        }
+    }
+
+    String getSummary() {
+        String summary = "";
+        if (have_core_stats) {
+            summary += "CPU:";
+            for (int core = 0; core < portNUM_PROCESSORS; core++) {
+                summary += " core" + String(core) + " " + String(core_percent[core]) + "%";
+            }
+            summary += have_cpu_stats ? "" : " (idle hooks)";
+            summary += "\n";
+        }
+        if (have_cpu_stats) {
+            // Three busiest tasks, ignoring the idle tasks
+            int shown = 0;
+            bool used[Config::MAX_TASKS] = {false};
+            summary += "Top:";
+            while (shown < 3) {
+                int best = -1;
+                for (int i = 0; i < task_count; i++) {
+                    if (used[i] || strncmp(tasks[i].name, "IDLE", 4) == 0) {
+                        continue;
+                    }
+                    if (best < 0 || tasks[i].cpuPercent > tasks[best].cpuPercent) {
+                        best = i;
+                    }
+                }
+                if (best < 0) {
+                    break;
+                }
+                used[best] = true;
+                summary += String(shown > 0 ? "," : "") + " " + String(tasks[best].name) + " " + String(tasks[best].cpuPercent) + "%";
+                shown++;
+            }
+            summary += "\n";
+        } else {
+            summary += "Per-task CPU: run-time stats not in this core\n";
+        }
+
+        int lowest = -1;
+        for (int i = 0; i < task_count; i++) {
+            if (lowest < 0 || tasks[i].stackFree < tasks[lowest].stackFree) {
+                lowest = i;
+            }
+        }
+        if (lowest >= 0) {
+            summary += "Min stack: " + String(tasks[lowest].name) + " " + String(tasks[lowest].stackFree) + " B free\n";
+        }
+
+        int p99 = jitterPercentile(99);
+        summary += "Loop: avg " + String(average_period / 1000.0f, 1) + " ms, jitter p99 " + (p99 < 0 ? String(">256") : "<=" + String(p99)) + " ms";
+        if (jitter_alerts > 0) {
+            summary += ", " + String(jitter_alerts) + " alerts";
+        }
+        return summary;
+    }
+
+    static String taskLabels(const TaskSample& sample) {
+        return "{task=\"" + String(sample.name) + "\",core=\"" + (sample.core < 0 ? String("any") : String(sample.core)) + "\"}";
+    }
+
+    String renderMetrics() {
+        String out;
+        out.reserve(1024);
+
+        // Each family is written in one block so the exposition stays valid
+        out += "# HELP signer_task_stack_free_bytes Lowest free stack per task\n";
+        out += "# TYPE signer_task_stack_free_bytes gauge\n";
+        for (int i = 0; i < task_count; i++) {
+            out += "signer_task_stack_free_bytes" + taskLabels(tasks[i]) + " " + String(tasks[i].stackFree) + "\n";
+        }
+        if (have_cpu_stats) {
+            out += "# HELP signer_task_cpu_percent CPU share per task over the last sample window\n";
+            out += "# TYPE signer_task_cpu_percent gauge\n";
+            for (int i = 0; i < task_count; i++) {
+                out += "signer_task_cpu_percent" + taskLabels(tasks[i]) + " " + String(tasks[i].cpuPercent) + "\n";
+            }
+        }
+        if (have_core_stats) {
+            out += "# HELP signer_core_cpu_percent CPU busy share per core over the last sample window\n";
+            out += "# TYPE signer_core_cpu_percent gauge\n";
+            for (int core = 0; core < portNUM_PROCESSORS; core++) {
+                out += "signer_core_cpu_percent{core=\"" + String(core) + "\"} " + String(core_percent[core]) + "\n";
+            }
+        }
+
+        out += "# HELP signer_loop_jitter_ms Deviation of the loop period from its running average\n";
+        out += "# TYPE signer_loop_jitter_ms histogram\n";
+        uint32_t cumulative = 0;
+        for (int i = 0; i < Config::JITTER_BUCKET_COUNT; i++) {
+            cumulative += jitter_buckets[i];
+            String bound = i == Config::JITTER_BUCKET_COUNT - 1 ? String("+Inf") : String(1 << i);
+            out += "signer_loop_jitter_ms_bucket{le=\"" + bound + "\"} " + String(cumulative) + "\n";
+        }
+        out += "signer_loop_jitter_ms_sum " + String((unsigned long long)jitter_sum_ms) + "\n";
+        out += "signer_loop_jitter_ms_count " + String(jitter_count) + "\n";
+        return out;
+    }
+}
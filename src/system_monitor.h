@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * CPU, stack and main loop monitor.
+ *
+ * Every SAMPLE_INTERVAL the FreeRTOS task list is snapshotted: each task's
+ * stack high-water mark, and, when the core is built with run-time stats,
+ * its share of CPU time since the previous sample. Per-core load is derived
+ * from the idle tasks. The prebuilt Arduino core leaves
+ * configGENERATE_RUN_TIME_STATS off; there, per-core load comes from idle
+ * hook wakeups counted against the tick rate, and per-task CPU is not
+ * available. TLS runs inside whichever task calls the WebSocket
+ * client (the Arduino loop task), so its cost shows up there.
+ *
+ * processLoop() is called once per main loop pass; the time between calls
+ * is the loop period, and its deviation from the running average is kept
+ * as a jitter histogram. Jitter above JITTER_ALERT_MS raises an alert.
+ */
+namespace SystemMonitor {
+    void processLoop();
+
+    // Short multi-line summary for the info screen
+    String getSummary();
+
+    // Prometheus lines for per-task series and the jitter histogram
+    String renderMetrics();
+
+    namespace Config {
+        const unsigned long SAMPLE_INTERVAL = 2000;
+        const int MAX_TASKS = 32;
+        const int JITTER_BUCKET_COUNT = 10;      // Upper bounds 1, 2, 4 ... 256 ms, then +Inf
+        const uint32_t JITTER_ALERT_MS = 50;
+        const unsigned long ALERT_LOG_INTERVAL = 10000;
+    }
+}
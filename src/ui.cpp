@@ -9,6 +9,12 @@
 #include "display.h"
 #include "remote_signer.h"
 #include "app.h"
+#include "metrics.h"
+#include "load_generator.h"
+#include "status_model.h"
+#include "ui_latency.h"
+#include "system_monitor.h"
+#include "relay_pool.h"
 
 // Forward declarations for external functions
 extern lv_obj_t* wifi_list;
@@ -33,6 +39,7 @@ namespace UI {
     
     // Signed events list
     static std::vector<SignedEvent> signed_events;
+    static const size_t MAX_SIGNED_EVENTS = 20;    // Newest first; older entries are dropped
     static lv_obj_t* signed_events_list = NULL;
     
     // Invoice overlay elements
@@ -167,17 +174,31 @@ namespace UI {
         // Status Bar
         main_wifi_status_label = lv_label_create(lv_scr_act());
         lv_obj_align(main_wifi_status_label, LV_ALIGN_TOP_LEFT, 10, 5);
-        lv_label_set_text(main_wifi_status_label, LV_SYMBOL_WIFI " Not Connected");
-        lv_obj_set_style_text_color(main_wifi_status_label, lv_color_hex(0x9E9E9E), 0);
+        StatusModel::bindLabel(main_wifi_status_label, StatusModel::FIELD_WIFI_STATUS);
 
         // Relay status label
         lv_obj_t* relay_status_label = lv_label_create(lv_scr_act());
         lv_obj_align(relay_status_label, LV_ALIGN_TOP_RIGHT, -10, 5);
-        lv_label_set_text(relay_status_label, "Relay: Disconnected");
-        lv_obj_set_style_text_color(relay_status_label, lv_color_hex(0x9E9E9E), 0);
-        
-        // Set reference for RemoteSigner module to update
-        RemoteSigner::setStatusLabel(relay_status_label);
+        StatusModel::bindLabel(relay_status_label, StatusModel::FIELD_RELAY_STATUS);
+        
+        // Link details under the status bar
+        lv_obj_t* rssi_label = lv_label_create(lv_scr_act());
+        lv_obj_align(rssi_label, LV_ALIGN_TOP_LEFT, 10, 22);
+        lv_obj_set_style_text_font(rssi_label, Fonts::FONT_SMALL, LV_PART_MAIN);
+        lv_obj_set_style_text_color(rssi_label, lv_color_hex(0x9E9E9E), 0);
+        StatusModel::bindLabel(rssi_label, StatusModel::FIELD_RSSI);
+        
+        lv_obj_t* clients_label = lv_label_create(lv_scr_act());
+        lv_obj_align(clients_label, LV_ALIGN_TOP_MID, 0, 22);
+        lv_obj_set_style_text_font(clients_label, Fonts::FONT_SMALL, LV_PART_MAIN);
+        lv_obj_set_style_text_color(clients_label, lv_color_hex(0x9E9E9E), 0);
+        StatusModel::bindLabel(clients_label, StatusModel::FIELD_CLIENT_COUNT);
+        
+        lv_obj_t* rtt_label = lv_label_create(lv_scr_act());
+        lv_obj_align(rtt_label, LV_ALIGN_TOP_RIGHT, -10, 22);
+        lv_obj_set_style_text_font(rtt_label, Fonts::FONT_SMALL, LV_PART_MAIN);
+        lv_obj_set_style_text_color(rtt_label, lv_color_hex(0x9E9E9E), 0);
+        StatusModel::bindLabel(rtt_label, StatusModel::FIELD_RELAY_RTT);
 
         // Main title
         lv_obj_t *title_label = lv_label_create(lv_scr_act());
@@ -277,8 +298,12 @@ namespace UI {
         lv_obj_set_style_bg_color(settings_btn, lv_color_hex(0x9E9E9E), LV_PART_MAIN);
         lv_obj_set_style_text_color(settings_btn, lv_color_hex(0x000000), LV_PART_MAIN);
         
-        // Set WiFi status label reference for WiFi module
-        WiFiManager::setMainStatusLabel(main_wifi_status_label);
+        // Most recent signature, just above the action buttons
+        lv_obj_t* last_signed_label = lv_label_create(lv_scr_act());
+        lv_obj_align(last_signed_label, LV_ALIGN_BOTTOM_MID, 0, -68);
+        lv_obj_set_style_text_font(last_signed_label, Fonts::FONT_SMALL, LV_PART_MAIN);
+        lv_obj_set_style_text_color(last_signed_label, lv_color_hex(0x9E9E9E), 0);
+        StatusModel::bindLabel(last_signed_label, StatusModel::FIELD_LAST_SIGNED_EVENT, true);
     }
     
     void createSettingsScreen() {
@@ -298,9 +323,8 @@ namespace UI {
         
         // WiFi status
         main_wifi_status_label = lv_label_create(main_container);
-        lv_label_set_text(main_wifi_status_label, LV_SYMBOL_WIFI " Not Connected");
         lv_obj_align(main_wifi_status_label, LV_ALIGN_TOP_RIGHT, 0, 13);
-        lv_obj_set_style_text_color(main_wifi_status_label, lv_color_hex(0x9E9E9E), 0);
+        StatusModel::bindLabel(main_wifi_status_label, StatusModel::FIELD_WIFI_STATUS);
         
         // Device Settings button
         lv_obj_t* device_settings_btn = lv_btn_create(main_container);
@@ -403,9 +427,6 @@ namespace UI {
         lv_obj_set_style_bg_color(back_btn, lv_color_hex(0x424242), LV_STATE_PRESSED);
         lv_obj_set_style_bg_opa(back_btn, LV_OPA_COVER, LV_STATE_PRESSED);
         lv_obj_set_style_text_color(back_btn, lv_color_hex(0xFFFFFF), LV_STATE_PRESSED);
-        
-        // Set WiFi status label reference
-        WiFiManager::setMainStatusLabel(main_wifi_status_label);
     }
     
     void createWiFiScreen() {
@@ -446,10 +467,10 @@ namespace UI {
         lv_obj_t* scan_text = lv_list_add_text(wifi_list, "Press Scan to find networks");
         lv_obj_set_style_text_color(scan_text, lv_color_hex(Colors::TEXT), LV_PART_MAIN);
         
-        // Scan button - positioned beneath the WiFi list with more spacing
+        // Scan buttons - positioned beneath the WiFi list with more spacing
         lv_obj_t* scan_btn = lv_btn_create(main_container);
-        lv_obj_set_size(scan_btn, lv_pct(100), 40);
-        lv_obj_align(scan_btn, LV_ALIGN_TOP_MID, 0, 390);
+        lv_obj_set_size(scan_btn, lv_pct(48), 40);
+        lv_obj_align(scan_btn, LV_ALIGN_TOP_LEFT, 0, 390);
         lv_obj_set_style_bg_color(scan_btn, lv_color_hex(Colors::PRIMARY), LV_PART_MAIN);
         lv_obj_add_event_cb(scan_btn, WiFiManager::scanEventHandler, LV_EVENT_CLICKED, NULL);
         
@@ -457,6 +478,17 @@ namespace UI {
         lv_label_set_text(scan_label, "Scan");
         lv_obj_center(scan_label);
         
+        // Quick rescan only revisits channels already in the list
+        lv_obj_t* refresh_btn = lv_btn_create(main_container);
+        lv_obj_set_size(refresh_btn, lv_pct(48), 40);
+        lv_obj_align(refresh_btn, LV_ALIGN_TOP_RIGHT, 0, 390);
+        lv_obj_set_style_bg_color(refresh_btn, lv_color_hex(Colors::PRIMARY), LV_PART_MAIN);
+        lv_obj_add_event_cb(refresh_btn, WiFiManager::quickScanEventHandler, LV_EVENT_CLICKED, NULL);
+        
+        lv_obj_t* refresh_label = lv_label_create(refresh_btn);
+        lv_label_set_text(refresh_label, LV_SYMBOL_REFRESH " Refresh");
+        lv_obj_center(refresh_label);
+        
         // Back button - old style at top left
         lv_obj_t* back_btn = lv_btn_create(lv_scr_act());
         lv_obj_set_size(back_btn, 40, 40);
@@ -524,12 +556,11 @@ namespace UI {
         lv_obj_set_style_text_color(password_textarea, lv_color_hex(0x9E9E9E), LV_PART_TEXTAREA_PLACEHOLDER);
         lv_obj_set_style_pad_all(password_textarea, 10, LV_PART_MAIN);
         
-        // Status label (hidden initially)
+        // Connection progress, hidden until an attempt starts
         lv_obj_t* status_label = lv_label_create(main_container);
         lv_obj_set_style_text_color(status_label, lv_color_hex(0xFFFFFF), 0);
         lv_obj_align(status_label, LV_ALIGN_CENTER, 0, 0);
-        lv_obj_add_flag(status_label, LV_OBJ_FLAG_HIDDEN);
-        WiFiManager::setStatusLabel(status_label);
+        StatusModel::bindLabel(status_label, StatusModel::FIELD_WIFI_CONNECT_PROGRESS, true);
         
         // Keyboard - full screen width
         lv_obj_t* kb = lv_keyboard_create(lv_scr_act());
@@ -730,6 +761,12 @@ namespace UI {
         lv_obj_t* hardware_info = lv_label_create(main_container);
         String hardware_text = "ESP32 - WT32-SC01\n";
         hardware_text += "Free Heap: " + String(ESP.getFreeHeap()) + " bytes\n";
+        
+        lv_mem_monitor_t lvgl_mem;
+        lv_mem_monitor(&lvgl_mem);
+        hardware_text += "LVGL Heap: " + String((lvgl_mem.total_size - lvgl_mem.free_size) / 1024) + "/" + String(lvgl_mem.total_size / 1024) + " KB (" + String(lvgl_mem.used_pct) + "%, frag " + String(lvgl_mem.frag_pct) + "%)\n";
+        hardware_text += "Render: max " + String(Metrics::getMax("lvgl_render_duration_ms")) + " ms over " + String(Metrics::getCounter("lvgl_render_duration_ms")) + " frames\n";
+        hardware_text += SystemMonitor::getSummary() + "\n";
         hardware_text += "WiFi MAC: " + WiFi.macAddress() + "\n";
         
         if (WiFiManager::isConnected()) {
@@ -746,6 +783,82 @@ namespace UI {
         lv_label_set_long_mode(hardware_info, LV_LABEL_LONG_WRAP);
         lv_obj_set_width(hardware_info, lv_pct(90));
         
+        // Diagnostics: loopback load test
+        lv_obj_t* load_test_btn = lv_btn_create(main_container);
+        lv_obj_set_size(load_test_btn, lv_pct(48), 40);
+        lv_obj_align(load_test_btn, LV_ALIGN_TOP_LEFT, 0, 530);
+        lv_obj_set_style_bg_color(load_test_btn, lv_color_hex(Colors::INFO), LV_PART_MAIN);
+        
+        lv_obj_t* load_test_btn_label = lv_label_create(load_test_btn);
+        lv_label_set_text(load_test_btn_label, LoadGenerator::isRunning() ? "Stop Load Test" : "Run Load Test");
+        lv_obj_center(load_test_btn_label);
+        
+        // Diagnostics: touch-to-photon latency overlay
+        lv_obj_t* latency_btn = lv_btn_create(main_container);
+        lv_obj_set_size(latency_btn, lv_pct(48), 40);
+        lv_obj_align(latency_btn, LV_ALIGN_TOP_RIGHT, 0, 530);
+        lv_obj_set_style_bg_color(latency_btn, lv_color_hex(Colors::INFO), LV_PART_MAIN);
+        
+        lv_obj_t* latency_btn_label = lv_label_create(latency_btn);
+        lv_label_set_text(latency_btn_label, UiLatency::isOverlayVisible() ? "Hide Latency" : "Show Latency");
+        lv_obj_center(latency_btn_label);
+        
+        lv_obj_add_event_cb(latency_btn, [](lv_event_t* e) {
+            lv_obj_t* btn_label = lv_obj_get_child(lv_event_get_target(e), 0);
+            UiLatency::setOverlayVisible(!UiLatency::isOverlayVisible());
+            lv_label_set_text(btn_label, UiLatency::isOverlayVisible() ? "Hide Latency" : "Show Latency");
+        }, LV_EVENT_CLICKED, NULL);
+        
+        // Diagnostics: memory soak over the same request mix
+        lv_obj_t* soak_btn = lv_btn_create(main_container);
+        lv_obj_set_size(soak_btn, lv_pct(100), 40);
+        lv_obj_align(soak_btn, LV_ALIGN_TOP_MID, 0, 580);
+        lv_obj_set_style_bg_color(soak_btn, lv_color_hex(Colors::INFO), LV_PART_MAIN);
+        
+        lv_obj_t* soak_btn_label = lv_label_create(soak_btn);
+        lv_label_set_text(soak_btn_label, LoadGenerator::isSoaking() ? "Stop Soak Test" : "Run Soak Test");
+        lv_obj_center(soak_btn_label);
+        
+        lv_obj_add_event_cb(soak_btn, [](lv_event_t* e) {
+            lv_obj_t* btn_label = lv_obj_get_child(lv_event_get_target(e), 0);
+            if (LoadGenerator::isSoaking()) {
+                LoadGenerator::stop();
+            } else if (!LoadGenerator::startSoak(LoadGenerator::Config::SOAK_REQUESTS)) {
+                showErrorToast(LoadGenerator::isRunning() ? "Load test already running" : "Signer keys not configured");
+                return;
+            }
+            lv_label_set_text(btn_label, LoadGenerator::isSoaking() ? "Stop Soak Test" : "Run Soak Test");
+        }, LV_EVENT_CLICKED, NULL);
+        
+        lv_obj_t* load_test_report = lv_label_create(main_container);
+        lv_label_set_text(load_test_report, (LoadGenerator::getReport() + "\n" + LoadGenerator::getSoakReport() + "\n" + RelayPool::getReport()).c_str());
+        lv_obj_align(load_test_report, LV_ALIGN_TOP_LEFT, 0, 630);
+        lv_obj_set_style_text_font(load_test_report, Fonts::FONT_SMALL, LV_PART_MAIN);
+        lv_obj_set_style_text_color(load_test_report, lv_color_hex(Colors::TEXT), 0);
+        lv_label_set_long_mode(load_test_report, LV_LABEL_LONG_WRAP);
+        lv_obj_set_width(load_test_report, lv_pct(90));
+        
+        lv_obj_add_event_cb(load_test_btn, [](lv_event_t* e) {
+            lv_obj_t* btn_label = lv_obj_get_child(lv_event_get_target(e), 0);
+            if (LoadGenerator::isRunning()) {
+                LoadGenerator::stop();
+            } else if (!LoadGenerator::start()) {
+                showErrorToast("Signer keys not configured");
+                return;
+            }
+            lv_label_set_text(btn_label, LoadGenerator::isRunning() ? "Stop Load Test" : "Run Load Test");
+        }, LV_EVENT_CLICKED, NULL);
+        
+        // Refresh the report while this screen is open
+        lv_timer_create([](lv_timer_t* timer) {
+            lv_obj_t* report = (lv_obj_t*)timer->user_data;
+            if (!lv_obj_is_valid(report)) {
+                lv_timer_del(timer);
+                return;
+            }
+            lv_label_set_text(report, (LoadGenerator::getReport() + "\n" + LoadGenerator::getSoakReport() + "\n" + RelayPool::getReport()).c_str());
+        }, 1000, load_test_report);
+        
         // Back button
         lv_obj_t* back_btn = lv_btn_create(lv_scr_act());
         lv_obj_set_size(back_btn, 40, 40);
@@ -819,7 +932,21 @@ namespace UI {
         Serial.println(title + ": " + message);
     }
 
-    void showConfirmationDialog(String title, String message, std::function<void(bool)> callback) {
+    // Confirmation dialogs currently on screen
+    static int open_dialogs = 0;
+
+    bool isConfirmationDialogOpen() {
+        return open_dialogs > 0;
+    }
+
+    // Hands the dialog's callback over exactly once; later calls get nullptr
+    static std::function<void(dialog_result_t)>* takeDialogCallback(lv_obj_t* overlay) {
+        std::function<void(dialog_result_t)>* callbackPtr = (std::function<void(dialog_result_t)>*)lv_obj_get_user_data(overlay);
+        lv_obj_set_user_data(overlay, nullptr);
+        return callbackPtr;
+    }
+
+    lv_obj_t* showConfirmationDialog(String title, String message, std::function<void(dialog_result_t)> callback) {
         // Create message overlay
         lv_obj_t* msg_overlay = lv_obj_create(lv_scr_act());
         lv_obj_set_size(msg_overlay, lv_pct(100), lv_pct(100));
@@ -853,7 +980,7 @@ namespace UI {
         lv_obj_set_style_text_align(msg_label, LV_TEXT_ALIGN_CENTER, 0);
         
         // Store callback in user data
-        std::function<void(bool)>* callbackPtr = new std::function<void(bool)>(callback);
+        std::function<void(dialog_result_t)>* callbackPtr = new std::function<void(dialog_result_t)>(callback);
         
         // Approve button
         lv_obj_t* approve_btn = lv_btn_create(msg_box);
@@ -863,9 +990,9 @@ namespace UI {
         lv_obj_add_event_cb(approve_btn, [](lv_event_t *e) {
             App::resetActivityTimer();
             lv_obj_t* overlay = (lv_obj_t*)lv_event_get_user_data(e);
-            std::function<void(bool)>* callbackPtr = (std::function<void(bool)>*)lv_obj_get_user_data(overlay);
+            std::function<void(dialog_result_t)>* callbackPtr = takeDialogCallback(overlay);
             if (callbackPtr) {
-                (*callbackPtr)(true);
+                (*callbackPtr)(DIALOG_APPROVED);
                 delete callbackPtr;
             }
             lv_obj_del(overlay);
@@ -883,9 +1010,9 @@ namespace UI {
         lv_obj_add_event_cb(deny_btn, [](lv_event_t *e) {
             App::resetActivityTimer();
             lv_obj_t* overlay = (lv_obj_t*)lv_event_get_user_data(e);
-            std::function<void(bool)>* callbackPtr = (std::function<void(bool)>*)lv_obj_get_user_data(overlay);
+            std::function<void(dialog_result_t)>* callbackPtr = takeDialogCallback(overlay);
             if (callbackPtr) {
-                (*callbackPtr)(false);
+                (*callbackPtr)(DIALOG_DENIED);
                 delete callbackPtr;
             }
             lv_obj_del(overlay);
@@ -898,7 +1025,25 @@ namespace UI {
         // Store callback pointer in overlay user data
         lv_obj_set_user_data(msg_overlay, callbackPtr);
         
+        // Deleted without a choice, e.g. by lv_obj_clean() on a screen change
+        open_dialogs++;
+        lv_obj_add_event_cb(msg_overlay, [](lv_event_t *e) {
+            open_dialogs--;
+            std::function<void(dialog_result_t)>* callbackPtr = takeDialogCallback(lv_event_get_target(e));
+            if (callbackPtr) {
+                (*callbackPtr)(DIALOG_DISMISSED);
+                delete callbackPtr;
+            }
+        }, LV_EVENT_DELETE, NULL);
+        
         Serial.println("Confirmation Dialog - " + title + ": " + message);
+        return msg_overlay;
+    }
+    
+    void closeConfirmationDialog(lv_obj_t* dialog) {
+        if (dialog != nullptr) {
+            lv_obj_del(dialog);
+        }
     }
     
     void navigationEventHandler(lv_event_t* e) {
@@ -1114,16 +1259,16 @@ namespace UI {
         event.timestamp = timestamp;
         // push event to the top of the vector
         signed_events.insert(signed_events.begin(), event);
+        if (signed_events.size() > MAX_SIGNED_EVENTS) {
+            signed_events.pop_back();
+        }
                 
         // Update the list if it exists and is valid
         if (signed_events_list && lv_obj_is_valid(signed_events_list)) {
             // Clear the list first
             lv_obj_clean(signed_events_list);
-            // reverse iterate through signed_events to show latest at top
-            std::vector<SignedEvent> signed_events_copy = signed_events;
-            std::reverse(signed_events_copy.begin(), signed_events_copy.end());
             
-            // Add all events back
+            // Add all events back, latest at top
             for (const auto& evt : signed_events) {
                 String item_text = evt.timestamp + " - " + getReadableEventKind(evt.eventKind);
                 lv_obj_t* btn = lv_list_add_btn(signed_events_list, LV_SYMBOL_OK, item_text.c_str());
@@ -1158,6 +1303,7 @@ namespace UI {
         
         // Add event to the persistent list instead of temporary notification
         addSignedEvent(eventKind, content, String(timeStr));
+        StatusModel::setLastSignedEvent(String(timeStr) + " - " + getReadableEventKind(eventKind));
         
         Serial.println("Event signed and added to persistent list: Kind " + eventKind);
     }
@@ -14,6 +14,13 @@ namespace UI {
         SCREEN_INFO
     } screen_state_t;
 
+    // Outcome of a confirmation dialog
+    typedef enum {
+        DIALOG_APPROVED,
+        DIALOG_DENIED,
+        DIALOG_DISMISSED        // Deleted without a choice
+    } dialog_result_t;
+
     // Initialization and cleanup
     void init();
     void cleanup();
@@ -34,7 +41,12 @@ namespace UI {
    
     // Message display
     void showMessage(String title, String message);
-    void showConfirmationDialog(String title, String message, std::function<void(bool)> callback);
+    // The callback runs exactly once: with the user's choice, or
+    // DIALOG_DISMISSED if the dialog is deleted first (closed, or cleared
+    // with its screen)
+    lv_obj_t* showConfirmationDialog(String title, String message, std::function<void(dialog_result_t)> callback);
+    void closeConfirmationDialog(lv_obj_t* dialog);
+    bool isConfirmationDialogOpen();
     
     // UI element accessors for other modules
     lv_obj_t* getWiFiList();
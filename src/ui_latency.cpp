@@ -0,0 +1,238 @@
+#include "ui_latency.h"
+#include "metrics.h"
+
+namespace UiLatency {
+    // Indexed by stage_t
+    static const char* const STAGE_NAMES[STAGE_COUNT] = {
+        "touch",
+        "input",
+        "render",
+        "flush",
+        "total"
+    };
+    static const char* const STAGE_METRICS[STAGE_COUNT] = {
+        "ui_touch_latency_us{stage=\"touch\"}",
+        "ui_touch_latency_us{stage=\"input\"}",
+        "ui_touch_latency_us{stage=\"render\"}",
+        "ui_touch_latency_us{stage=\"flush\"}",
+        "ui_touch_latency_us{stage=\"total\"}"
+    };
+
+    struct Histogram {
+        uint32_t buckets[Config::BUCKET_COUNT] = {0};
+        uint32_t count = 0;
+        uint32_t last = 0;
+    };
+
+    // Timestamps (micros) of the press being traced; 0 until the stage is reached
+    struct Trace {
+        bool active = false;
+        uint32_t interrupt = 0;
+        uint32_t read = 0;
+        bool dispatched = false;
+        uint32_t handled = 0;
+        uint32_t flushed = 0;
+    };
+
+    static Histogram histograms[STAGE_COUNT];
+    static Trace trace;
+    static uint32_t dropped = 0;
+
+    static volatile bool injected_pending = false;
+    static int16_t injected_x = 0;
+    static int16_t injected_y = 0;
+    static uint32_t injected_at = 0;
+
+    static lv_obj_t* overlay_label = nullptr;
+    static lv_timer_t* overlay_timer = nullptr;
+    static String overlay_text;
+    // The overlay's own redraw must not be mistaken for a traced press's
+    static bool overlay_refresh_pending = false;
+
+    static int bucketFor(uint32_t elapsedMicros) {
+        uint32_t bound = 1000;
+        for (int i = 0; i < Config::BUCKET_COUNT - 1; i++) {
+            if (elapsedMicros <= bound) {
+                return i;
+            }
+            bound *= 2;
+        }
+        return Config::BUCKET_COUNT - 1;
+    }
+
+    static void record(stage_t stage, uint32_t elapsedMicros) {
+        Histogram& histogram = histograms[stage];
+        histogram.buckets[bucketFor(elapsedMicros)]++;
+        histogram.count++;
+        histogram.last = elapsedMicros;
+        Metrics::observe(STAGE_METRICS[stage], elapsedMicros);
+    }
+
+    // Upper bound in ms of the bucket holding the given percentile, -1 for +Inf
+    static int percentileBound(const Histogram& histogram, int percentile) {
+        uint32_t rank = (histogram.count * percentile + 99) / 100;
+        uint32_t seen = 0;
+        for (int i = 0; i < Config::BUCKET_COUNT; i++) {
+            seen += histogram.buckets[i];
+            if (seen >= rank) {
+                return i == Config::BUCKET_COUNT - 1 ? -1 : (1 << i);
+            }
+        }
+        return -1;
+    }
+
+    static String formatBound(int bound) {
+        return bound < 0 ? String(">256") : "<=" + String(bound);
+    }
+
+    static void dropExpiredTrace() {
+        if (trace.active && micros() - trace.read > Config::TRACE_TIMEOUT_US) {
+            trace.active = false;
+            dropped++;
+            Metrics::increment("ui_touch_traces_dropped_total");
+        }
+    }
+
+    void touchPressed(uint32_t interruptMicros) {
+        dropExpiredTrace();
+        if (trace.active || overlay_refresh_pending) {
+            return;
+        }
+        trace.active = true;
+        trace.read = micros();
+        // An interrupt older than the timeout belongs to an earlier press
+        trace.interrupt = (trace.read - interruptMicros) < Config::TRACE_TIMEOUT_US ? interruptMicros : trace.read;
+        trace.dispatched = false;
+        trace.handled = 0;
+        trace.flushed = 0;
+    }
+
+    // LVGL calls feedback_cb before the event reaches the object's handlers,
+    // so this only notes that the press was dispatched
+    static void inputFeedback(lv_indev_drv_t* driver, uint8_t eventCode) {
+        if (trace.active && trace.handled == 0) {
+            trace.dispatched = true;
+        }
+    }
+
+    // Handlers run synchronously inside the read pass, so they are done here
+    static void inputReadTimer(lv_timer_t* timer) {
+        lv_indev_read_timer_cb(timer);
+        if (trace.active && trace.dispatched && trace.handled == 0) {
+            trace.handled = micros();
+        }
+    }
+
+    void attachInput(lv_indev_t* indev) {
+        if (indev == nullptr || indev->driver->read_timer == nullptr) {
+            return;
+        }
+        indev->driver->feedback_cb = inputFeedback;
+        lv_timer_set_cb(indev->driver->read_timer, inputReadTimer);
+    }
+
+    void flushStarted() {
+        if (trace.active && trace.handled != 0 && trace.flushed == 0) {
+            trace.flushed = micros();
+        }
+    }
+
+    void refreshFinished() {
+        overlay_refresh_pending = false;
+        dropExpiredTrace();
+        if (!trace.active || trace.flushed == 0) {
+            return;
+        }
+
+        uint32_t done = micros();
+        record(STAGE_TOUCH, trace.read - trace.interrupt);
+        record(STAGE_INPUT, trace.handled - trace.read);
+        record(STAGE_RENDER, trace.flushed - trace.handled);
+        record(STAGE_FLUSH, done - trace.flushed);
+        record(STAGE_TOTAL, done - trace.interrupt);
+        trace.active = false;
+    }
+
+    bool isTracing() {
+        dropExpiredTrace();
+        return trace.active;
+    }
+
+    void injectTouch(int16_t x, int16_t y) {
+        injected_x = x;
+        injected_y = y;
+        injected_at = micros();
+        injected_pending = true;
+    }
+
+    bool takeInjectedTouch(int16_t& x, int16_t& y, uint32_t& injectedMicros) {
+        if (!injected_pending) {
+            return false;
+        }
+        x = injected_x;
+        y = injected_y;
+        injectedMicros = injected_at;
+        injected_pending = false;
+        return true;
+    }
+
+    String getReport() {
+        if (histograms[STAGE_TOTAL].count == 0) {
+            return "No touches traced (" + String(dropped) + " without redraw)";
+        }
+
+        String report = String(histograms[STAGE_TOTAL].count) + " touches, " + String(dropped) + " without redraw\n";
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            const Histogram& histogram = histograms[i];
+            int p50 = percentileBound(histogram, 50);
+            int p95 = percentileBound(histogram, 95);
+            report += String(STAGE_NAMES[i]) + ": last " + String(histogram.last / 1000.0f, 1) + " ms, p50 " + formatBound(p50) + ", p95 " + formatBound(p95) + " ms\n";
+        }
+        return report;
+    }
+
+    static void setOverlayText(const String& text) {
+        if (text == overlay_text) {
+            return;
+        }
+        overlay_text = text;
+        lv_label_set_text(overlay_label, overlay_text.c_str());
+        overlay_refresh_pending = true;
+    }
+
+    // Held back while a trace is running so the redraw stays out of it
+    static void overlayTimerCB(lv_timer_t* timer) {
+        if (overlay_label != nullptr && !isTracing()) {
+            setOverlayText(getReport());
+        }
+    }
+
+    void setOverlayVisible(bool visible) {
+        if (visible == isOverlayVisible()) {
+            return;
+        }
+
+        if (visible) {
+            overlay_label = lv_label_create(lv_layer_top());
+            lv_obj_set_width(overlay_label, lv_pct(100));
+            lv_obj_align(overlay_label, LV_ALIGN_BOTTOM_MID, 0, 0);
+            lv_obj_set_style_bg_color(overlay_label, lv_color_hex(0x000000), 0);
+            lv_obj_set_style_bg_opa(overlay_label, LV_OPA_70, 0);
+            lv_obj_set_style_text_color(overlay_label, lv_color_hex(0x00FF00), 0);
+            lv_obj_set_style_text_font(overlay_label, &lv_font_montserrat_12, 0);
+            lv_obj_set_style_pad_all(overlay_label, 4, 0);
+            overlay_text = "";
+            setOverlayText(getReport());
+            overlay_timer = lv_timer_create(overlayTimerCB, Config::OVERLAY_REFRESH_MS, NULL);
+        } else {
+            lv_timer_del(overlay_timer);
+            overlay_timer = nullptr;
+            lv_obj_del(overlay_label);
+            overlay_label = nullptr;
+        }
+    }
+
+    bool isOverlayVisible() {
+        return overlay_label != nullptr;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+/**
+ * Touch-to-photon latency tracing.
+ *
+ * Each new press is followed from the touch controller interrupt to the
+ * end of the display refresh that first puts a change on screen:
+ *
+ *   touch    interrupt -> touchpadRead() reports the press
+ *   input    touchpadRead() -> end of the indev read pass that dispatched
+ *            the press's first event, so its handlers have returned
+ *   render   handlers done -> first flush of the invalidated area
+ *   flush    first flush -> refresh complete (monitor_cb)
+ *
+ * Presses that cause no redraw within TRACE_TIMEOUT_US are dropped.
+ * Presses arriving while an overlay update is still waiting for its
+ * refresh are not traced, and the overlay is not updated mid-trace.
+ * Stage times feed per-stage histograms, the ui_touch_* metrics and an
+ * optional overlay on the top layer.
+ */
+namespace UiLatency {
+    typedef enum {
+        STAGE_TOUCH,
+        STAGE_INPUT,
+        STAGE_RENDER,
+        STAGE_FLUSH,
+        STAGE_TOTAL,
+        STAGE_COUNT
+    } stage_t;
+
+    // Pipeline hooks, called from the display backend
+    void attachInput(lv_indev_t* indev);
+    void touchPressed(uint32_t interruptMicros);
+    void flushStarted();
+    void refreshFinished();
+    bool isTracing();
+
+    // Synthetic presses for builds without a touch controller
+    void injectTouch(int16_t x, int16_t y);
+    bool takeInjectedTouch(int16_t& x, int16_t& y, uint32_t& injectedMicros);
+
+    // Results
+    String getReport();
+    void setOverlayVisible(bool visible);
+    bool isOverlayVisible();
+
+    namespace Config {
+        const int BUCKET_COUNT = 10;                     // Upper bounds 1, 2, 4 ... 256 ms, then +Inf
+        const uint32_t TRACE_TIMEOUT_US = 1000000;
+        const uint32_t OVERLAY_REFRESH_MS = 500;
+    }
+}
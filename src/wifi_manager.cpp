@@ -1,10 +1,19 @@
 #include "wifi_manager.h"
 #include <WiFi.h>
+#include <functional>
 #include "settings.h"
 #include "app.h"
 
 #include "ui.h"
 #include "remote_signer.h"
+#include "peer_coordinator.h"
+#include "metrics.h"
+#include "status_model.h"
+#include "relay_url.h"
+#include "cert_pins.h"
+#include "relay_pool.h"
+#include "asset_store.h"
+#include <signer_trace.h>
 
 // Import Nostr library components for key derivation
 #include "../lib/nostr/nostr.h"
@@ -17,7 +26,18 @@ namespace WiFiManager {
     // Connection management
     static unsigned long wifi_connect_start_time = 0;
     static const unsigned long WIFI_CONNECT_TIMEOUT = 10000; // 10 seconds
+    static const unsigned long WIFI_PASSWORD_CONNECT_TIMEOUT = 15000; // New networks entered on screen
+    static const unsigned long RSSI_SAMPLE_INTERVAL = 5000;
     static bool wifi_connection_attempted = false;
+    static bool wifi_connection_timed_out = false;
+    static bool save_credentials_on_connect = false;
+    
+    // Link state model: written by the WiFi event task, consumed in processLoop()
+    static volatile wifi_link_state_t link_state = WIFI_LINK_IDLE;
+    static volatile bool link_state_changed = false;
+    static volatile uint8_t last_disconnect_reason = 0;
+    static volatile unsigned long link_lost_time = 0;
+    static wifi_link_state_t reported_link_state = WIFI_LINK_IDLE;
     static char current_ssid[33];
     static char current_password[65];
     
@@ -34,13 +54,32 @@ namespace WiFiManager {
     static QueueHandle_t wifi_scan_result_queue = NULL;
     
     // UI elements
-    static lv_obj_t* wifi_status_label = NULL;
-    static lv_obj_t* main_wifi_status_label = NULL;
     static lv_timer_t* wifi_scan_timer = NULL;
-    static lv_timer_t* wifi_status_timer = NULL;
+    static lv_timer_t* wifi_connect_timeout_timer = NULL;
+    
+    // Scan settings
+    static const uint8_t WIFI_SCAN_MAX_CHANNEL = 13;
+    static const uint16_t WIFI_SCAN_ALL_CHANNELS = 0x3FFE;  // Bits 1..13
+    static const uint32_t WIFI_SCAN_MS_PER_CHANNEL = 150;
+    static const unsigned long WIFI_SCAN_CHANNEL_TIMEOUT = 1500;
+    static const int WIFI_SCAN_QUEUE_LENGTH = 32;
+    static const int WIFI_SCAN_ENTRIES_PER_TICK = 4;  // Bounds list work per LVGL frame
+    static const int MAX_SCAN_RESULTS = 20;
     
-    // SSID storage for UI
-    static std::vector<String> wifi_ssids;
+    // Networks shown in the WiFi list, one slot per SSID. Slots stay put so
+    // list buttons can refer to them; display order is kept by RSSI.
+    struct ScanSlot {
+        char ssid[33];
+        int8_t rssi;
+        uint8_t channel;
+        bool encrypted;
+        bool active;
+        uint8_t generation;  // Scan that last updated this slot
+        lv_obj_t* button;
+    };
+    static ScanSlot scan_table[MAX_SCAN_RESULTS];
+    static uint8_t scan_generation = 0;
+    static lv_obj_t* scan_placeholder = NULL;
     
     // Status callback
     static wifi_status_callback_t status_callback = nullptr;
@@ -51,6 +90,76 @@ namespace WiFiManager {
     // Preferences instance
     static Preferences preferences;
     
+    static void sendScanEntry(const wifi_scan_entry_t& entry) {
+        if (wifi_scan_result_queue == NULL) {
+            return;
+        }
+        // Block briefly so a slow UI drains the queue instead of losing entries
+        if (xQueueSend(wifi_scan_result_queue, &entry, pdMS_TO_TICKS(200)) != pdTRUE) {
+            Serial.println("WiFiManager - Scan result queue full, dropping entry");
+        }
+    }
+    
+    static bool isStopScanPending() {
+        wifi_command_t pending;
+        return xQueuePeek(wifi_command_queue, &pending, 0) == pdTRUE && pending.type == WIFI_STOP_SCAN;
+    }
+    
+    // Scans one channel at a time so results stream out per channel rather
+    // than arriving all at once after a full sweep. Runs on the WiFi task.
+    static void runChannelSweep(uint16_t channel_mask) {
+        unsigned long sweep_start = millis();
+        int found = 0;
+        
+        for (uint8_t channel = 1; channel <= WIFI_SCAN_MAX_CHANNEL; channel++) {
+            if (!(channel_mask & (1 << channel))) {
+                continue;
+            }
+            if (isStopScanPending()) {
+                Serial.println("WiFiManager - Scan stopped");
+                break;
+            }
+            
+            TRACE_SCOPE("wifi_scan_channel");
+            int16_t n = WiFi.scanNetworks(true, false, false, WIFI_SCAN_MS_PER_CHANNEL, channel);
+            unsigned long channel_start = millis();
+            while (n == WIFI_SCAN_RUNNING && millis() - channel_start < WIFI_SCAN_CHANNEL_TIMEOUT) {
+                vTaskDelay(pdMS_TO_TICKS(20));
+                n = WiFi.scanComplete();
+            }
+            
+            if (n < 0) {
+                Serial.println("WiFiManager - Scan of channel " + String(channel) + " failed: " + String(n));
+                WiFi.scanDelete();
+                continue;
+            }
+            
+            for (int i = 0; i < n; i++) {
+                String ssid = WiFi.SSID(i);
+                if (ssid.length() == 0) {
+                    continue;  // Hidden network
+                }
+                
+                wifi_scan_entry_t entry = {};
+                strncpy(entry.ssid, ssid.c_str(), 32);
+                entry.ssid[32] = '\0';
+                entry.rssi = WiFi.RSSI(i);
+                entry.channel = WiFi.channel(i);
+                entry.encrypted = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
+                sendScanEntry(entry);
+                found++;
+            }
+            WiFi.scanDelete();
+        }
+        
+        wifi_scan_entry_t done = {};
+        done.done = true;
+        sendScanEntry(done);
+        
+        Metrics::observe("wifi_scan_duration_ms", millis() - sweep_start);
+        Serial.println("WiFiManager - Scan completed, " + String(found) + " results in " + String(millis() - sweep_start) + "ms");
+    }
+    
     // WiFi task function - runs on Core 0
     static void wifiTask(void *parameter) {
         Serial.println("WiFi task started");
@@ -73,53 +182,17 @@ namespace WiFiManager {
                         WiFi.mode(WIFI_STA);
                         delay(100);
                         
-                        int n = WiFi.scanNetworks();
-                        Serial.print("Scan completed, found ");
-                        Serial.print(n);
-                        Serial.println(" networks");
-                        
-                        wifi_scan_result_t result;
-                        
-                        // Check for scan errors (negative return values)
-                        if (n < 0) {
-                            Serial.print("WiFi scan failed with error code: ");
-                            Serial.println(n);
-                            Serial.println("Retrying scan in 1 second...");
-                            delay(1000);
-                            
-                            // Retry scan once
-                            n = WiFi.scanNetworks();
-                            Serial.print("Retry scan found ");
-                            Serial.print(n);
-                            Serial.println(" networks");
-                        }
-                        
-                        if (n < 0) {
-                            Serial.println("Scan failed after retry, returning empty results");
-                            result.network_count = 0;
-                        } else {
-                            result.network_count = (n > 9) ? 9 : n;
-                            
-                            for (int i = 0; i < result.network_count; i++) {
-                                strncpy(result.ssids[i], WiFi.SSID(i).c_str(), 32);
-                                result.ssids[i][32] = '\0';
-                                result.rssi[i] = WiFi.RSSI(i);
-                                result.encrypted[i] = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
-                            }
-                        }
+                        runChannelSweep(command.channel_mask);
                         
                         // Re-enable auto-reconnect for normal operation
                         WiFi.setAutoReconnect(true);
-                        
-                        if (wifi_scan_result_queue != NULL) {
-                            if (xQueueSend(wifi_scan_result_queue, &result, 0) == pdTRUE) {
-                                Serial.println("Scan results sent to queue successfully");
-                            } else {
-                                Serial.println("Failed to send scan results to queue");
-                            }
-                        }
                         break;
                     }
+                    case WIFI_QUICK_SCAN:
+                        // Scans from the associated station, so the link and the relay stay up
+                        Serial.println("Starting quick WiFi scan...");
+                        runChannelSweep(command.channel_mask);
+                        break;
                     case WIFI_CONNECT:
                         Serial.println("Connecting to WiFi...");
                         WiFi.begin(command.ssid, command.password);
@@ -137,85 +210,132 @@ namespace WiFiManager {
         }
     }
     
-    // Status checker callback
-    static void wifiStatusCheckerCB(lv_timer_t *timer) {
-        lv_obj_t* status_label = (lv_obj_t*)timer->user_data;
-        int attempts = (int)lv_obj_get_user_data(status_label);
-        attempts++;
-
-        if (WiFi.status() == WL_CONNECTED) {
-            lv_label_set_text_fmt(status_label, "Connected!\nIP: %s", WiFi.localIP().toString().c_str());
-            
-            preferences.begin("wifi-creds", false);
-            preferences.putString("ssid", current_ssid);
-            preferences.putString("password", current_password);
-            preferences.end();
-            Serial.println("WiFi credentials saved.");
-
-            lv_timer_del(timer);
-            wifi_status_timer = NULL;
+    // Runs on the WiFi event task: only record the transition here
+    static void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+        switch (event) {
+            case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+                Trace::instant("wifi_sta_connected");
+                if (link_state != WIFI_LINK_UP) {
+                    link_state = WIFI_LINK_CONNECTING;
+                    link_state_changed = true;
+                }
+                break;
+            case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+                Trace::instant("wifi_got_ip");
+                link_state = WIFI_LINK_UP;
+                link_state_changed = true;
+                break;
+            case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+                Trace::instant("wifi_link_down");
+                if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+                    last_disconnect_reason = info.wifi_sta_disconnected.reason;
+                }
+                if (link_state == WIFI_LINK_UP) {
+                    link_lost_time = millis();
+                }
+                link_state = WIFI_LINK_DOWN;
+                link_state_changed = true;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    static const char* linkStateName(wifi_link_state_t state) {
+        switch (state) {
+            case WIFI_LINK_IDLE: return "idle";
+            case WIFI_LINK_CONNECTING: return "connecting";
+            case WIFI_LINK_UP: return "up";
+            case WIFI_LINK_DOWN: return "down";
+            default: return "unknown";
+        }
+    }
+    
+    static void publishWifiStatus() {
+        if (ap_mode_active) {
+            StatusModel::setWifiStatus("AP Mode Active", 0x4CAF50);
+        } else if (reported_link_state == WIFI_LINK_UP) {
+            StatusModel::setWifiStatus(String(LV_SYMBOL_WIFI) + " " + WiFi.SSID(), 0x00FF00);
+        } else if (wifi_connection_timed_out) {
+            StatusModel::setWifiStatus(LV_SYMBOL_WIFI " Timeout", 0xFF5722);
+        } else {
+            StatusModel::setWifiStatus(LV_SYMBOL_WIFI " Not Connected", 0x9E9E9E);
+        }
+        StatusModel::setRssi(reported_link_state == WIFI_LINK_UP ? WiFi.RSSI() : 0);
+    }
+    
+    // One-shot timer armed by startConnection()
+    static void connectTimeoutCB(lv_timer_t *timer) {
+        wifi_connect_timeout_timer = NULL;
+        if (link_state == WIFI_LINK_UP) {
             return;
         }
-
-        if (attempts > 30) { // 15-second timeout
-            lv_label_set_text(status_label, "Connection Failed!");
+        
+        Serial.println("WiFiManager - Connection attempt timed out");
+        wifi_connection_attempted = false;
+        wifi_connection_timed_out = true;
+        
+        if (save_credentials_on_connect) {
+            save_credentials_on_connect = false;
+            StatusModel::setWifiConnectProgress("Connection Failed!");
             WiFi.disconnect(true);
-            lv_timer_del(timer);
-            wifi_status_timer = NULL;
-            return;
         }
-
-        lv_obj_set_user_data(status_label, (void*)attempts);
-        delay(1);
+        publishWifiStatus();
     }
     
-    // Main status updater callback
-    static void mainStatusUpdaterCB(lv_timer_t *timer) {
-        if (ap_mode_active) {
-            if (main_wifi_status_label != NULL && lv_obj_is_valid(main_wifi_status_label)) {
-                lv_label_set_text(main_wifi_status_label, "AP Mode Active");
-                lv_obj_set_style_text_color(main_wifi_status_label, lv_color_hex(0x4CAF50), 0);
-            }
-            // Relay status will be handled by external modules
+    static void handleLinkStateChange() {
+        wifi_link_state_t state = link_state;
+        if (state == reported_link_state) {
             return;
         }
-
-        if (main_wifi_status_label != NULL && lv_obj_is_valid(main_wifi_status_label)) {
-            if (WiFi.status() == WL_CONNECTED) {
-                String status_text = String(LV_SYMBOL_WIFI) + " " + WiFi.SSID();
-                lv_label_set_text(main_wifi_status_label, status_text.c_str());
-                lv_obj_set_style_text_color(main_wifi_status_label, lv_color_hex(0x00FF00), 0);
-            } else {
-                unsigned long current_time = millis();
-                if (wifi_connection_attempted && (current_time - wifi_connect_start_time > WIFI_CONNECT_TIMEOUT)) {
-                    lv_label_set_text(main_wifi_status_label, LV_SYMBOL_WIFI " Timeout");
-                    lv_obj_set_style_text_color(main_wifi_status_label, lv_color_hex(0xFF5722), 0);
-                } else {
-                    lv_label_set_text(main_wifi_status_label, LV_SYMBOL_WIFI " Not Connected");
-                    lv_obj_set_style_text_color(main_wifi_status_label, lv_color_hex(0x9E9E9E), 0);
-                }
+        
+        TRACE_SCOPE("wifi_link_change");
+        bool was_up = reported_link_state == WIFI_LINK_UP;
+        reported_link_state = state;
+        Serial.println("WiFiManager - Link " + String(linkStateName(state)) + (state == WIFI_LINK_DOWN ? " (reason " + String(last_disconnect_reason) + ")" : ""));
+        
+        if (state == WIFI_LINK_UP) {
+            wifi_connection_attempted = false;
+            wifi_connection_timed_out = false;
+            if (wifi_connect_timeout_timer != NULL) {
+                lv_timer_del(wifi_connect_timeout_timer);
+                wifi_connect_timeout_timer = NULL;
             }
+            
+            if (save_credentials_on_connect) {
+                save_credentials_on_connect = false;
+                preferences.begin("wifi-creds", false);
+                preferences.putString("ssid", current_ssid);
+                preferences.putString("password", current_password);
+                preferences.end();
+                Serial.println("WiFi credentials saved.");
+                
+                StatusModel::setWifiConnectProgress("Connected!\nIP: " + WiFi.localIP().toString());
+            }
+        } else if (was_up) {
+            Metrics::increment("wifi_link_losses_total");
         }
         
-        if (status_callback) {
-            status_callback(WiFi.status() == WL_CONNECTED, 
-                           WiFi.status() == WL_CONNECTED ? "Connected" : "Disconnected");
-        }
+        publishWifiStatus();
         
-        delay(1);
+        if (status_callback && (state == WIFI_LINK_UP) != was_up) {
+            status_callback(state == WIFI_LINK_UP, state == WIFI_LINK_UP ? "Connected" : "Disconnected");
+        }
     }
     
     void init() {
+        WiFi.onEvent(onWiFiEvent);
         WiFi.mode(WIFI_STA);
+        publishWifiStatus();
         timeClient.begin();
         timeClient.setTimeOffset(0);
         
         // Create queues
         wifi_command_queue = xQueueCreate(10, sizeof(wifi_command_t));
-        wifi_scan_result_queue = xQueueCreate(5, sizeof(wifi_scan_result_t));
+        wifi_scan_result_queue = xQueueCreate(WIFI_SCAN_QUEUE_LENGTH, sizeof(wifi_scan_entry_t));
         
         createTask();
-        createStatusTimer();
         
         // Load Bunker URL
         loadBunkerUrl();
@@ -240,7 +360,7 @@ namespace WiFiManager {
     
     void cleanup() {
         deleteTask();
-        deleteStatusTimer();
+        WiFi.removeEvent(onWiFiEvent);
         
         if (wifi_command_queue) {
             vQueueDelete(wifi_command_queue);
@@ -254,6 +374,18 @@ namespace WiFiManager {
     }
     
     void processLoop() {
+        if (link_state_changed) {
+            link_state_changed = false;
+            handleLinkStateChange();
+        }
+        
+        // Signal strength has no event; sample it and let the model drop repeats
+        static unsigned long last_rssi_sample = 0;
+        if (reported_link_state == WIFI_LINK_UP && millis() - last_rssi_sample >= RSSI_SAMPLE_INTERVAL) {
+            last_rssi_sample = millis();
+            StatusModel::setRssi(WiFi.RSSI());
+        }
+        
         if (isAPModeActive()) {
             dns_server.processNextRequest();
             ap_server.handleClient();
@@ -278,6 +410,13 @@ namespace WiFiManager {
         
         wifi_connect_start_time = millis();
         wifi_connection_attempted = true;
+        wifi_connection_timed_out = false;
+        
+        if (wifi_connect_timeout_timer != NULL) {
+            lv_timer_del(wifi_connect_timeout_timer);
+        }
+        wifi_connect_timeout_timer = lv_timer_create(connectTimeoutCB, save_credentials_on_connect ? WIFI_PASSWORD_CONNECT_TIMEOUT : WIFI_CONNECT_TIMEOUT, NULL);
+        lv_timer_set_repeat_count(wifi_connect_timeout_timer, 1);
     }
     
     void disconnect() {
@@ -289,7 +428,19 @@ namespace WiFiManager {
     }
     
     bool isConnected() {
-        return WiFi.status() == WL_CONNECTED;
+        return link_state == WIFI_LINK_UP;
+    }
+    
+    wifi_link_state_t getLinkState() {
+        return link_state;
+    }
+    
+    uint8_t getLastDisconnectReason() {
+        return last_disconnect_reason;
+    }
+    
+    unsigned long getLinkLostTime() {
+        return link_lost_time;
     }
     
     String getSSID() {
@@ -304,19 +455,29 @@ namespace WiFiManager {
         return WiFi.status();
     }
     
-    void startScan() {
-        Serial.println("Scanning for WiFi networks...");
-        if (UI::getWiFiList()) {
-            lv_obj_clean(UI::getWiFiList());
-            lv_obj_t* scanning_text = lv_list_add_text(UI::getWiFiList(), "Scanning for networks...");
-            lv_obj_set_style_bg_opa(scanning_text, LV_OPA_TRANSP, LV_PART_MAIN);
-            lv_obj_set_style_text_color(scanning_text, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
-            lv_obj_set_style_pad_all(scanning_text, 5, LV_PART_MAIN);
+    static void setScanPlaceholder(const char* text) {
+        lv_obj_t* list = UI::getWiFiList();
+        if (!list) {
+            return;
         }
-        
+        if (scan_placeholder == NULL || !lv_obj_is_valid(scan_placeholder)) {
+            scan_placeholder = lv_list_add_text(list, text);
+            lv_obj_set_style_bg_opa(scan_placeholder, LV_OPA_TRANSP, LV_PART_MAIN);
+            lv_obj_set_style_text_color(scan_placeholder, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+            lv_obj_set_style_pad_all(scan_placeholder, 5, LV_PART_MAIN);
+        } else {
+            lv_label_set_text(scan_placeholder, text);
+        }
+        // Keep the status line below the sorted networks
+        lv_obj_move_to_index(scan_placeholder, lv_obj_get_child_cnt(list) - 1);
+    }
+    
+    static void sendScanCommand(wifi_command_type_t type, uint16_t channel_mask) {
+        scan_generation++;
         if (wifi_command_queue != NULL) {
             wifi_command_t command;
-            command.type = WIFI_SCAN;
+            command.type = type;
+            command.channel_mask = channel_mask;
             if (xQueueSend(wifi_command_queue, &command, 0) == pdTRUE) {
                 Serial.println("Scan command sent to WiFi task successfully");
             } else {
@@ -324,12 +485,127 @@ namespace WiFiManager {
             }
         }
         
-        wifi_scan_timer = lv_timer_create([](lv_timer_t *timer) {
-            if (processScanResults()) {
-                lv_timer_del(timer);
-                wifi_scan_timer = NULL;
+        if (wifi_scan_timer == NULL) {
+            wifi_scan_timer = lv_timer_create([](lv_timer_t *timer) {
+                if (processScanResults()) {
+                    lv_timer_del(timer);
+                    wifi_scan_timer = NULL;
+                }
+            }, 100, NULL);
+        }
+    }
+    
+    void startScan() {
+        Serial.println("Scanning for WiFi networks...");
+        for (int i = 0; i < MAX_SCAN_RESULTS; i++) {
+            scan_table[i].active = false;
+            scan_table[i].button = NULL;
+        }
+        scan_placeholder = NULL;
+        
+        if (UI::getWiFiList()) {
+            lv_obj_clean(UI::getWiFiList());
+            setScanPlaceholder("Scanning for networks...");
+        }
+        
+        sendScanCommand(WIFI_SCAN, WIFI_SCAN_ALL_CHANNELS);
+    }
+    
+    void startQuickScan() {
+        uint16_t channel_mask = 0;
+        for (int i = 0; i < MAX_SCAN_RESULTS; i++) {
+            if (scan_table[i].active && scan_table[i].channel >= 1 && scan_table[i].channel <= WIFI_SCAN_MAX_CHANNEL) {
+                channel_mask |= (1 << scan_table[i].channel);
+            }
+        }
+        
+        // Nothing known yet, so there is nothing to narrow the scan to
+        if (channel_mask == 0) {
+            startScan();
+            return;
+        }
+        
+        Serial.println("Quick scan of known channels, mask 0x" + String(channel_mask, HEX));
+        setScanPlaceholder("Refreshing...");
+        sendScanCommand(WIFI_QUICK_SCAN, channel_mask);
+    }
+    
+    static int findScanSlot(const char* ssid) {
+        for (int i = 0; i < MAX_SCAN_RESULTS; i++) {
+            if (scan_table[i].active && strcmp(scan_table[i].ssid, ssid) == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    
+    // Merge one result into the table: within a scan the strongest BSSID
+    // wins for a repeated SSID, and a full table only admits a stronger network.
+    static int mergeScanEntry(const wifi_scan_entry_t& entry) {
+        int slot = findScanSlot(entry.ssid);
+        if (slot != -1) {
+            if (scan_table[slot].generation == scan_generation && entry.rssi <= scan_table[slot].rssi) {
+                return -1;
+            }
+        } else {
+            int weakest = -1;
+            for (int i = 0; i < MAX_SCAN_RESULTS; i++) {
+                if (!scan_table[i].active) {
+                    slot = i;
+                    break;
+                }
+                if (weakest == -1 || scan_table[i].rssi < scan_table[weakest].rssi) {
+                    weakest = i;
+                }
+            }
+            if (slot == -1) {
+                if (entry.rssi <= scan_table[weakest].rssi) {
+                    return -1;
+                }
+                slot = weakest;
+            }
+            strncpy(scan_table[slot].ssid, entry.ssid, sizeof(scan_table[slot].ssid));
+            scan_table[slot].active = true;
+        }
+        
+        scan_table[slot].rssi = entry.rssi;
+        scan_table[slot].channel = entry.channel;
+        scan_table[slot].encrypted = entry.encrypted;
+        scan_table[slot].generation = scan_generation;
+        return slot;
+    }
+    
+    static void updateScanListItem(int slot) {
+        lv_obj_t* list = UI::getWiFiList();
+        if (!list) {
+            return;
+        }
+        
+        ScanSlot& network = scan_table[slot];
+        String item_text = String(network.ssid) + " (" + String(network.rssi) + " dBm) " + (network.encrypted ? "Lck" : " ");
+        
+        if (network.button == NULL || !lv_obj_is_valid(network.button)) {
+            network.button = lv_list_add_btn(list, NULL, item_text.c_str());
+            lv_obj_add_event_cb(network.button, connectEventHandler, LV_EVENT_CLICKED, (void*)(uintptr_t)slot);
+            
+            // Style the list button - transparent background with white text
+            lv_obj_set_style_bg_opa(network.button, LV_OPA_TRANSP, LV_PART_MAIN);
+            lv_obj_set_style_text_color(network.button, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+            lv_obj_set_style_border_width(network.button, 0, LV_PART_MAIN);
+            lv_obj_set_style_outline_width(network.button, 0, LV_PART_MAIN);
+        } else {
+            lv_label_set_text(lv_obj_get_child(network.button, 0), item_text.c_str());
+        }
+        
+        // The other rows are already sorted, so placing this one keeps the list sorted
+        int rank = 0;
+        for (int i = 0; i < MAX_SCAN_RESULTS; i++) {
+            if (i != slot && scan_table[i].active && scan_table[i].button != NULL &&
+                (scan_table[i].rssi > network.rssi || (scan_table[i].rssi == network.rssi && i < slot))) {
+                rank++;
             }
-        }, 500, NULL);
+        }
+        lv_obj_move_to_index(network.button, rank);
     }
     
     bool processScanResults() {
@@ -337,52 +613,36 @@ namespace WiFiManager {
             return false;
         }
         
-        wifi_scan_result_t result;
-        if (xQueueReceive(wifi_scan_result_queue, &result, 0)) {
-            Serial.print("Found ");
-            Serial.print(result.network_count);
-            Serial.println(" networks.");
+        wifi_scan_entry_t entry;
+        for (int processed = 0; processed < WIFI_SCAN_ENTRIES_PER_TICK; processed++) {
+            if (!xQueueReceive(wifi_scan_result_queue, &entry, 0)) {
+                return false;
+            }
             
-            if (UI::getWiFiList()) {
-                lv_obj_clean(UI::getWiFiList());
-                
-                if (result.network_count == 0) {
-                    lv_list_add_text(UI::getWiFiList(), "No networks found");
-                } else {
-                    wifi_ssids.clear();
-                    wifi_ssids.reserve(result.network_count);
-                    
-                    for (int i = 0; i < result.network_count; i++) {
-                        String ssid = String(result.ssids[i]);
-                        wifi_ssids.push_back(ssid);
-                        
-                        String rssi = String(result.rssi[i]);
-                        String security = result.encrypted[i] ? "Lck" : " ";
-                        String item_text = ssid + " (" + rssi + " dBm) " + security;
-                        
-                        Serial.print("Adding network: ");
-                        Serial.println(item_text);
-                        
-                        lv_obj_t* list_btn = lv_list_add_btn(UI::getWiFiList(), NULL, item_text.c_str());
-                        lv_obj_add_event_cb(list_btn, connectEventHandler, LV_EVENT_CLICKED, (void*)(uintptr_t)i);
-                        
-                        // Style the list button - transparent background with white text
-                        lv_obj_set_style_bg_opa(list_btn, LV_OPA_TRANSP, LV_PART_MAIN);
-                        lv_obj_set_style_text_color(list_btn, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
-                        lv_obj_set_style_border_width(list_btn, 0, LV_PART_MAIN);
-                        lv_obj_set_style_outline_width(list_btn, 0, LV_PART_MAIN);
-                        
-                        if (i % 3 == 0) {
-                            delay(1);
-                        }
+            if (entry.done) {
+                bool any = false;
+                for (int i = 0; i < MAX_SCAN_RESULTS; i++) {
+                    any = any || scan_table[i].active;
+                }
+                if (any) {
+                    if (scan_placeholder != NULL && lv_obj_is_valid(scan_placeholder)) {
+                        lv_obj_del(scan_placeholder);
                     }
+                    scan_placeholder = NULL;
+                } else {
+                    setScanPlaceholder("No networks found");
                 }
+                return true;
+            }
+            
+            int slot = mergeScanEntry(entry);
+            if (slot != -1) {
+                updateScanListItem(slot);
             }
-            return true;
         }
         return false;
     }
-      
+    
     void startAPMode() {
         if (ap_mode_active) {
             Serial.println("AP mode already active");
@@ -424,6 +684,7 @@ namespace WiFiManager {
         
         ap_server.begin();
         ap_mode_active = true;
+        publishWifiStatus();
         
         Serial.println("Access Point started successfully");
         updateSettingsScreenForAPMode();
@@ -441,6 +702,7 @@ namespace WiFiManager {
         WiFi.softAPdisconnect(true);
         WiFi.mode(WIFI_STA);
         ap_mode_active = false;
+        publishWifiStatus();
         
         Serial.println("Access Point stopped");
         
@@ -490,14 +752,6 @@ namespace WiFiManager {
         return RemoteSigner::getBunkerUrl();
     }
     
-    void setStatusLabel(lv_obj_t* label) {
-        wifi_status_label = label;
-    }
-    
-    void setMainStatusLabel(lv_obj_t* label) {
-        main_wifi_status_label = label;
-    }
-    
     // Event handlers
     void scanEventHandler(lv_event_t* e) {
         if (e != NULL) {
@@ -507,6 +761,12 @@ namespace WiFiManager {
         startScan();
     }
     
+    void quickScanEventHandler(lv_event_t* e) {
+        lv_event_code_t code = lv_event_get_code(e);
+        if (code != LV_EVENT_CLICKED) return;
+        startQuickScan();
+    }
+    
     void connectEventHandler(lv_event_t* e) {
         lv_event_code_t code = lv_event_get_code(e);
         if (code == LV_EVENT_CLICKED) {
@@ -515,10 +775,11 @@ namespace WiFiManager {
             
             int index = (int)(uintptr_t)lv_event_get_user_data(e);
             
-            if (index < wifi_ssids.size()) {
-                const char* ssid = wifi_ssids[index].c_str();
+            if (index >= 0 && index < MAX_SCAN_RESULTS && scan_table[index].active) {
+                const char* ssid = scan_table[index].ssid;
                 Serial.print("Selected WiFi network: ");
                 Serial.println(ssid);
+                StatusModel::setWifiConnectProgress("");
                 UI::createWiFiPasswordScreen(ssid);
             } else {
                 Serial.println("Invalid WiFi network index");
@@ -544,18 +805,11 @@ namespace WiFiManager {
             lv_obj_add_flag(kb, LV_OBJ_FLAG_HIDDEN);
             lv_obj_add_flag(ta, LV_OBJ_FLAG_HIDDEN);
 
-            if (wifi_status_label) {
-                lv_obj_clear_flag(wifi_status_label, LV_OBJ_FLAG_HIDDEN);
-                lv_label_set_text(wifi_status_label, "Connecting...");
-                lv_obj_align(wifi_status_label, LV_ALIGN_CENTER, 0, 0);
-                lv_obj_set_user_data(wifi_status_label, (void*)0);
-            }
+            StatusModel::setWifiConnectProgress("Connecting...");
 
+            // Credentials are saved and the label updated once GOT_IP arrives
+            save_credentials_on_connect = true;
             startConnection(current_ssid, current_password);
-
-            if (wifi_status_label) {
-                wifi_status_timer = lv_timer_create(wifiStatusCheckerCB, 500, wifi_status_label);
-            }
         } else if (code == LV_EVENT_CANCEL) {
             pauseBackgroundOperations(false);
             UI::loadScreen((UI::screen_state_t)2); // SCREEN_WIFI
@@ -613,93 +867,98 @@ namespace WiFiManager {
         status_callback = callback;
     }
     
-    void createStatusTimer() {
-        lv_timer_create(mainStatusUpdaterCB, 1000, NULL);
-    }
-    
-    void deleteStatusTimer() {
-        // Timers are automatically cleaned up when objects are deleted
+    // Plain pages built into the app image, served when the asset partition was
+    // never flashed so the signer can still be configured. They post the core
+    // fields only; the full pages come with 'pio run -t uploadassets'.
+    static const char FALLBACK_CONFIG_PAGE[] = R"(<!DOCTYPE html>
+<html><head><title>Nostr Remote Signer Configuration</title><meta name="viewport" content="width=device-width, initial-scale=1"></head>
+<body><h1>Nostr Remote Signer</h1>
+<p>Basic page - flash the full pages with 'pio run -t uploadassets'.</p>
+<form action="/config" method="post">
+<p><label>Private key (64-character hex)<br><input type="password" name="private_key" required value="{{private_key}}"></label></p>
+<p><label>Relay URL<br><input type="text" name="relay_url" required value="{{relay_url}}"></label></p>
+<p><label>Unencrypted ws:// allow-list<br><input type="text" name="ws_allow" value="{{ws_allow}}"></label></p>
+<p><label>Client timeout (seconds)<br><input type="number" name="request_timeout" min="5" max="600" value="{{request_timeout}}"></label></p>
+<p><label>Relay certificate check<br><select name="tls_verify">
+<option value="2" {{tls_chain}}>Full chain validation</option>
+<option value="1" {{tls_pin}}>Pin on first connect</option>
+<option value="0" {{tls_none}}>No verification</option>
+</select></label></p>
+<p><label><input type="checkbox" name="repin" value="1"> Forget the pinned key</label></p>
+<p><button type="submit">Save Configuration</button></p>
+</form></body></html>
+)";
+
+    static const char FALLBACK_SAVED_PAGE[] = R"(<!DOCTYPE html>
+<html><head><title>Configuration Saved</title><meta name="viewport" content="width=device-width, initial-scale=1"></head>
+<body><h1>Configuration saved</h1>
+<p>Public key: {{public_key}}</p>
+<p>Relay: {{relay_url}}</p>
+<p><a href="/">Back to Configuration</a></p>
+</body></html>
+)";
+
+    // Streams a page from the asset partition, or the built-in fallback when the
+    // pack is missing, filling {{key}} placeholders from lookup
+    static void sendPage(const char* assetName, const char* fallback, std::function<String(const String&)> lookup) {
+        AssetStore::Asset page;
+        if (!AssetStore::get(assetName, page)) {
+            page.data = (const uint8_t*)fallback;
+            page.size = strlen(fallback);
+        }
+
+        ap_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        ap_server.send(200, "text/html", "");
+
+        const char* text = (const char*)page.data;
+        size_t position = 0;
+        while (position < page.size) {
+            const char* open = (const char*)memmem(text + position, page.size - position, "{{", 2);
+            if (open == nullptr) {
+                break;
+            }
+            size_t keyStart = open - text + 2;
+            const char* close = (const char*)memmem(text + keyStart, page.size - keyStart, "}}", 2);
+            if (close == nullptr) {
+                break;
+            }
+            // An empty chunk would end the response early
+            if (open > text + position) {
+                ap_server.sendContent(text + position, open - text - position);
+            }
+            String value = lookup(String(text + keyStart, close - text - keyStart));
+            if (value.length() > 0) {
+                ap_server.sendContent(value);
+            }
+            position = close - text + 2;
+        }
+        if (position < page.size) {
+            ap_server.sendContent(text + position, page.size - position);
+        }
+        ap_server.sendContent("");
     }
-    
+
     void handleAPRoot() {
-        String html = R"(
-<!DOCTYPE html>
-<html>
-<head>
-    <title>Nostr Remote Signer Configuration</title>
-    <meta name="viewport" content="width=device-width, initial-scale=1">
-    <style>
-        body { font-family: Arial, sans-serif; margin: 20px; background-color: #f5f5f5; }
-        .container { max-width: 600px; margin: 0 auto; background: white; padding: 20px; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }
-        .form-group { margin-bottom: 20px; }
-        label { display: block; margin-bottom: 5px; font-weight: bold; color: #333; }
-        input[type="text"], input[type="password"], textarea { width: 100%; padding: 10px; border: 1px solid #ddd; border-radius: 4px; font-size: 14px; }
-        textarea { height: 60px; resize: vertical; }
-        button { background-color: #4CAF50; color: white; padding: 12px 24px; border: none; border-radius: 4px; cursor: pointer; font-size: 16px; }
-        button:hover { background-color: #45a049; }
-        .info { background-color: #e7f3ff; padding: 15px; border-radius: 4px; margin-bottom: 20px; word-wrap: break-word; }
-        .warning { background-color: #fff3cd; border: 1px solid #ffeaa7; padding: 15px; border-radius: 4px; margin-bottom: 20px; }
-        .generate-btn { background-color: #2196F3; margin-left: 10px; padding: 8px 16px; font-size: 14px; }
-        .generate-btn:hover { background-color: #1976D2; }
-        .form-row { display: flex; align-items: end; gap: 10px; }
-        .form-row input { flex: 1; }
-        h1 { color: #333; text-align: center; }
-        .subtitle { text-align: center; color: #666; margin-bottom: 30px; }
-        .current-config { font-family: monospace; font-size: 12px; }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <h1>🔐 Nostr Remote Signer</h1>
-        <p class="subtitle">Configure your device to act as a secure remote signer for Nostr applications</p>
-        
-        <div class="warning">
-            <strong>⚠️ Security Notice:</strong> Your private key will be stored securely on this device. Never share it with anyone or enter it on untrusted websites.
-        </div>
-        
-        <div class="info">
-            <strong>Current Bunker URL:</strong><br>
-            <span id="current-url" class="current-config">Loading...</span>
-        </div>
-        
-        <form action="/config" method="post">
-            <div class="form-group">
-                <label for="private_key">Nostr Private Key (64-character hex):</label>
-                <input type="password" id="private_key" name="private_key" placeholder="64-character hex private key" required value="{{private_key}}">
-                <small style="color: #666;">Enter your Nostr private key as 64 hex characters</small>
-            </div>
-            
-            <div class="form-group">
-                <label for="relay_url">Nostr Relay URL:</label>
-                <input type="text" id="relay_url" name="relay_url" placeholder="wss://relay.nostrconnect.com" required value="{{relay_url}}">
-                <small style="color: #666;">WebSocket URL of the Nostr relay to connect to</small>
-            </div>
-            
-            <div class="form-group">
-                <label for="public_key">Public Key (readonly):</label>
-                <input type="text" id="public_key" name="public_key" readonly style="background-color: #f8f9fa;">
-                <small style="color: #666;">This will be automatically calculated from your private key</small>
-            </div>
-            
-            <button type="submit" style="width: 100%;">Save Configuration</button>
-        </form>
-    </div>
-</body>
-</html>
-        )";
-        // now fill in current values
         String currentRelay = RemoteSigner::getRelayUrl();
         String currentPrivateKey = RemoteSigner::getPrivateKey();
-        if (currentPrivateKey.length() > 0) {
-            html.replace("{{private_key}}", currentPrivateKey);
-        }
-        if (currentRelay.length() > 0) {
-            html.replace("{{relay_url}}", currentRelay);
-        } else {
-            html.replace("{{relay_url}}", "wss://relay.nostrconnect.com");
-        }
+        CertPins::verify_mode_t tlsMode = CertPins::getMode();
+        RelayPool::pool_mode_t publishMode = RelayPool::getMode();
 
-        ap_server.send(200, "text/html", html);
+        sendPage("web/config.html", FALLBACK_CONFIG_PAGE, [&](const String& key) -> String {
+            if (key == "private_key") return currentPrivateKey;
+            if (key == "relay_url") return currentRelay.length() > 0 ? currentRelay : String("wss://relay.nostrconnect.com");
+            if (key == "peer_mode") return PeerCoordinator::isEnabled() ? "checked" : "";
+            if (key == "ws_allow") return RemoteSigner::getPlaintextAllowList();
+            if (key == "request_timeout") return String(RemoteSigner::getRequestTimeout());
+            if (key == "tls_none") return tlsMode == CertPins::TLS_VERIFY_NONE ? "selected" : "";
+            if (key == "tls_pin") return tlsMode == CertPins::TLS_VERIFY_PIN ? "selected" : "";
+            if (key == "tls_chain") return tlsMode == CertPins::TLS_VERIFY_CHAIN ? "selected" : "";
+            if (key == "publish_off") return publishMode == RelayPool::POOL_OFF ? "selected" : "";
+            if (key == "publish_watch") return publishMode == RelayPool::POOL_WATCH ? "selected" : "";
+            if (key == "publish_device") return publishMode == RelayPool::POOL_PUBLISH ? "selected" : "";
+            if (key == "write_relays") return RelayPool::getRelayUrls();
+            return "";
+        });
     }
     
     void handleAPConfig() {
@@ -715,6 +974,18 @@ namespace WiFiManager {
         Serial.println("Private Key length: " + String(privateKey.length()));
         Serial.println("Relay URL: " + relayUrl);
         
+        // Validate relay URL and ws:// allow-list
+        RelayUrl::Parts relay;
+        if (!RelayUrl::parse(relayUrl, relay)) {
+            ap_server.send(400, "text/plain", "Invalid relay URL - use ws://host[:port][/path] or wss://host[:port][/path]");
+            return;
+        }
+        String wsAllowList = ap_server.hasArg("ws_allow") ? ap_server.arg("ws_allow") : "";
+        if (!relay.secure && !RelayUrl::isPlaintextAllowed(relay.host, wsAllowList)) {
+            ap_server.send(400, "text/plain", "ws:// relays must be on the unencrypted allow-list");
+            return;
+        }
+        
         // Validate private key format
         if (privateKey.length() != 64 && !privateKey.startsWith("nsec1")) {
             ap_server.send(400, "text/plain", "Invalid private key format");
@@ -748,6 +1019,54 @@ namespace WiFiManager {
             return;
         }
         
+        // Optional shared device key
+        String deviceKey = ap_server.hasArg("device_key") ? ap_server.arg("device_key") : "";
+        deviceKey.trim();
+        if (deviceKey.length() > 0 && !RemoteSigner::isValidPubKeyHex(deviceKey)) {
+            ap_server.send(400, "text/plain", "Invalid shared device key - use 64 hex characters");
+            return;
+        }
+        
+        // Write relays are checked against the submitted allow-list, not the stored one
+        int publishMode = RelayPool::POOL_OFF;
+        String writeRelays = "";
+        if (ap_server.hasArg("publish_mode")) {
+            publishMode = constrain(ap_server.arg("publish_mode").toInt(), RelayPool::POOL_OFF, RelayPool::POOL_PUBLISH);
+            writeRelays = ap_server.hasArg("write_relays") ? ap_server.arg("write_relays") : "";
+            writeRelays.trim();
+            if (!RelayPool::validate(writeRelays, wsAllowList)) {
+                ap_server.send(400, "text/plain", "Invalid write relays - up to 3 wss:// URLs (ws:// only for allow-listed hosts)");
+                return;
+            }
+        }
+        
+        // Everything is valid; nothing below rejects the form
+        if (deviceKey.length() > 0 && !RemoteSigner::importDeviceKeypair(deviceKey)) {
+            ap_server.send(500, "text/plain", "Failed to store the shared device key");
+            return;
+        }
+        // An unchecked box is not submitted, so only pages that carry it may turn it off
+        if (ap_server.hasArg("peer_mode_present")) {
+            PeerCoordinator::setEnabled(ap_server.hasArg("peer_mode"));
+        }
+        RemoteSigner::setPlaintextAllowList(wsAllowList);
+        if (ap_server.hasArg("request_timeout") && ap_server.arg("request_timeout").toInt() > 0) {
+            RemoteSigner::setRequestTimeout(ap_server.arg("request_timeout").toInt());
+        }
+        if (ap_server.hasArg("publish_mode")) {
+            RelayPool::configure((RelayPool::pool_mode_t)publishMode, writeRelays);
+        }
+        if (ap_server.hasArg("tls_verify")) {
+            int mode = constrain(ap_server.arg("tls_verify").toInt(), CertPins::TLS_VERIFY_NONE, CertPins::TLS_VERIFY_CHAIN);
+            CertPins::setMode((CertPins::verify_mode_t)mode);
+        }
+        if (ap_server.hasArg("repin") && relay.secure) {
+            CertPins::forget(relay.host + ":" + String(relay.port));
+        }
+        if (ap_server.hasArg("repin_write")) {
+            RelayPool::forgetPins();
+        }
+        
         // Save configuration to RemoteSigner
         RemoteSigner::setRelayUrl(relayUrl);
         RemoteSigner::setPrivateKey(privateKeyHex);
@@ -762,46 +1081,11 @@ namespace WiFiManager {
         
         Serial.println("Remote Signer configuration saved successfully");
         
-        String html = R"(
-<!DOCTYPE html>
-<html>
-<head>
-    <title>Configuration Saved</title>
-    <meta name="viewport" content="width=device-width, initial-scale=1">
-    <style>
-        body { font-family: Arial, sans-serif; margin: 20px; text-align: center; background-color: #f5f5f5; }
-        .container { max-width: 500px; margin: 0 auto; background: white; padding: 30px; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }
-        .success { color: #4CAF50; font-size: 24px; margin: 20px 0; }
-        .info { background-color: #e7f3ff; padding: 15px; border-radius: 4px; margin: 20px 0; }
-        .back-btn { background-color: #2196F3; color: white; padding: 12px 24px; text-decoration: none; border-radius: 4px; display: inline-block; margin-top: 20px; }
-        .config-item { margin: 10px 0; text-align: left; }
-        .config-label { font-weight: bold; color: #333; }
-        .config-value { font-family: monospace; font-size: 12px; word-break: break-all; color: #666; }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <div class="success">✓ Configuration saved successfully!</div>
-        
-        <div class="info">
-            <div class="config-item">
-                <div class="config-label">Public Key:</div>
-                <div class="config-value">)" + publicKeyHex + R"(</div>
-            </div>
-            <div class="config-item">
-                <div class="config-label">Relay:</div>
-                <div class="config-value">)" + relayUrl + R"(</div>
-            </div>
-        </div>
-        
-        <p>Your remote signer is now configured and ready to use.</p>
-        <a href="/" class="back-btn">Back to Configuration</a>
-    </div>
-</body>
-</html>
-        )";
-        
-        ap_server.send(200, "text/html", html);
+        sendPage("web/saved.html", FALLBACK_SAVED_PAGE, [&](const String& key) -> String {
+            if (key == "public_key") return publicKeyHex;
+            if (key == "relay_url") return relayUrl;
+            return "";
+        });
     }
     
     void handleCurrentConfig() {
@@ -19,6 +19,7 @@ namespace WiFiManager {
     // WiFi command types
     typedef enum {
         WIFI_SCAN,
+        WIFI_QUICK_SCAN,        // Known channels only, without leaving the current network
         WIFI_CONNECT,
         WIFI_DISCONNECT,
         WIFI_STOP_SCAN
@@ -29,15 +30,25 @@ namespace WiFiManager {
         wifi_command_type_t type;
         char ssid[33];
         char password[65];
+        uint16_t channel_mask;  // WIFI_SCAN/WIFI_QUICK_SCAN: bit n set scans channel n
     } wifi_command_t;
 
-    // WiFi scan result structure
+    // One network streamed from the WiFi task while a scan sweeps channels
     typedef struct {
-        int network_count;
-        char ssids[9][33];  // Store up to 9 SSIDs
-        int rssi[9];
-        bool encrypted[9];
-    } wifi_scan_result_t;
+        char ssid[33];
+        int8_t rssi;
+        uint8_t channel;
+        bool encrypted;
+        bool done;  // End-of-scan marker, no network data
+    } wifi_scan_entry_t;
+
+    // Link state, driven by WiFi.onEvent() transitions
+    typedef enum {
+        WIFI_LINK_IDLE,
+        WIFI_LINK_CONNECTING,
+        WIFI_LINK_UP,
+        WIFI_LINK_DOWN
+    } wifi_link_state_t;
 
     // Initialization
     void init();
@@ -48,12 +59,16 @@ namespace WiFiManager {
     void startConnection(const char* ssid, const char* password);
     void disconnect();
     bool isConnected();
+    wifi_link_state_t getLinkState();
+    uint8_t getLastDisconnectReason();
+    unsigned long getLinkLostTime();  // millis() of the last up -> down transition, 0 if never
     String getSSID();
     String getLocalIP();
     wl_status_t getStatus();
     
     // Network scanning
     void startScan();
+    void startQuickScan();  // Rescan only channels already in the list
     bool processScanResults();
     
     // Access Point mode
@@ -68,12 +83,9 @@ namespace WiFiManager {
     void loadBunkerUrl();
     String getBunkerUrl();
     
-    // Status monitoring
-    void setStatusLabel(lv_obj_t* label);
-    void setMainStatusLabel(lv_obj_t* label);
-    
     // Event handlers for UI integration
     void scanEventHandler(lv_event_t* e);
+    void quickScanEventHandler(lv_event_t* e);
     void connectEventHandler(lv_event_t* e);
     void passwordKBEventHandler(lv_event_t* e);
     void passwordBackEventHandler(lv_event_t* e);
@@ -95,10 +107,6 @@ namespace WiFiManager {
     void pauseBackgroundOperations(bool pause);
     bool isBackgroundOperationsPaused();
     
-    // Timer management
-    void createStatusTimer();
-    void deleteStatusTimer();
-    
     // AP mode web server handlers
     void handleAPRoot();
     void handleAPConfig();
@@ -0,0 +1,153 @@
+/**
+ * Worst-case inputs for the request parsing and crypto paths.
+ *
+ * Each test builds the largest or most hostile input of one class, runs it
+ * through the same lib/nostr entry points the signer uses, and records the
+ * processing time and heap retained. The bounds below are ceilings: a
+ * class that exceeds its budget, leaks, or is not rejected fails the run.
+ *
+ * Runs on the device: pio test -e esp32-s3-n16r8v -f test_input_bounds
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include <esp_heap_caps.h>
+#include <vector>
+
+#include "../../lib/nostr/nostr.h"
+#include "../../lib/nostr/nip44/nip44.h"
+
+// Sized like the firmware's initMemorySpace() call, scaled to fit beside the test
+static const size_t EVENT_DOC_SIZE = 200000;
+static const size_t MESSAGE_BIN_SIZE = 100000;
+
+// Budgets per input class
+static const uint32_t REJECT_BUDGET_US = 20000;          // Cheap rejections before any decoding
+static const uint32_t NESTING_BUDGET_US = 50000;         // One scan of a max-size frame
+static const uint32_t NIP04_WORST_BUDGET_US = 400000;    // ECDH plus AES-CBC over the whole buffer
+static const uint32_t NIP44_WORST_BUDGET_US = 400000;    // Base64 plus HMAC over a 65535-byte pad
+static const int32_t RETAINED_BUDGET_BYTES = 256;
+
+static const char* PRIVATE_KEY = "0000000000000000000000000000000000000000000000000000000000000003";
+static const char* PEER_PUBLIC_KEY = "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798";
+static const char* SHARED_SECRET = "0101010101010101010101010101010101010101010101010101010101010101";
+
+struct Measurement {
+    uint32_t elapsed_us;
+    int32_t retained_bytes;
+    int32_t peak_bytes;     // Below the previous low-water mark; 0 if it was not crossed
+};
+
+// Runner: time one call and record what it costs in heap
+template <typename F>
+static Measurement measure(const char* inputClass, F run) {
+    size_t freeBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t lowBefore = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+
+    uint32_t start = micros();
+    run();
+    Measurement result;
+    result.elapsed_us = micros() - start;
+
+    size_t lowAfter = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    result.retained_bytes = (int32_t)freeBefore - (int32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    result.peak_bytes = lowAfter < lowBefore ? (int32_t)freeBefore - (int32_t)lowAfter : 0;
+
+    char line[160];
+    snprintf(line, sizeof(line), "%s: %u us, retained %d B, peak %d B", inputClass, result.elapsed_us, result.retained_bytes, result.peak_bytes);
+    TEST_MESSAGE(line);
+    return result;
+}
+
+// Generators
+static String repeat(char c, size_t count) {
+    String out;
+    out.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        out += c;
+    }
+    return out;
+}
+
+static String randomBase64(size_t binaryLength, uint8_t firstByte) {
+    std::vector<uint8_t> bytes(binaryLength);
+    esp_fill_random(bytes.data(), bytes.size());
+    bytes[0] = firstByte;
+    return base64_encode(bytes.data(), bytes.size());
+}
+
+static String nestedTagsFrame(size_t depth) {
+    return "[\"EVENT\",\"signer\",{\"pubkey\":\"" + String(PEER_PUBLIC_KEY) + "\",\"content\":\"x\",\"tags\":" + repeat('[', depth) + repeat(']', depth) + "}]";
+}
+
+void test_deeply_nested_tags_are_rejected() {
+    // As deep as a 96 KB frame allows
+    String frame = nestedTagsFrame(48 * 1024);
+    std::pair<String, String> result;
+    Measurement m = measure("nested tags (48k levels)", [&]() { result = nostr::getPubKeyAndContent(frame); });
+    TEST_ASSERT_EQUAL(0, result.first.length());
+    TEST_ASSERT_LESS_THAN_UINT32(NESTING_BUDGET_US, m.elapsed_us);
+    TEST_ASSERT_LESS_THAN_INT32(RETAINED_BUDGET_BYTES, m.retained_bytes);
+}
+
+void test_oversized_nip04_iv_is_rejected() {
+    String cipherText = randomBase64(32, 0) + "?iv=" + repeat('A', 96 * 1024);
+    String decrypted;
+    Measurement m = measure("nip04 96 KB iv", [&]() { decrypted = nostr::decryptNip04Ciphertext(cipherText, PRIVATE_KEY, PEER_PUBLIC_KEY); });
+    TEST_ASSERT_EQUAL(0, decrypted.length());
+    TEST_ASSERT_LESS_THAN_UINT32(REJECT_BUDGET_US, m.elapsed_us);
+    TEST_ASSERT_LESS_THAN_INT32(RETAINED_BUDGET_BYTES, m.retained_bytes);
+}
+
+void test_oversized_nip04_ciphertext_is_rejected() {
+    String cipherText = randomBase64(MESSAGE_BIN_SIZE + 16, 0) + "?iv=" + randomBase64(16, 0);
+    String decrypted;
+    Measurement m = measure("nip04 ciphertext over buffer", [&]() { decrypted = nostr::decryptNip04Ciphertext(cipherText, PRIVATE_KEY, PEER_PUBLIC_KEY); });
+    TEST_ASSERT_EQUAL(0, decrypted.length());
+    TEST_ASSERT_LESS_THAN_UINT32(REJECT_BUDGET_US, m.elapsed_us);
+    TEST_ASSERT_LESS_THAN_INT32(RETAINED_BUDGET_BYTES, m.retained_bytes);
+}
+
+void test_largest_admitted_nip04_ciphertext_is_bounded() {
+    // Fills the decode buffer exactly; decryption runs and fails on padding
+    String cipherText = randomBase64(MESSAGE_BIN_SIZE - MESSAGE_BIN_SIZE % 16, 0) + "?iv=" + randomBase64(16, 0);
+    Measurement m = measure("nip04 full buffer", [&]() { nostr::decryptNip04Ciphertext(cipherText, PRIVATE_KEY, PEER_PUBLIC_KEY); });
+    TEST_ASSERT_LESS_THAN_UINT32(NIP04_WORST_BUDGET_US, m.elapsed_us);
+    TEST_ASSERT_LESS_THAN_INT32(RETAINED_BUDGET_BYTES, m.retained_bytes);
+}
+
+void test_oversized_nip44_payload_is_rejected() {
+    String payload = repeat('A', NIP44_MAX_PAYLOAD_LENGTH + 4);
+    String decrypted;
+    Measurement m = measure("nip44 over max payload", [&]() { decrypted = decryptMessageNip44(payload, SHARED_SECRET); });
+    TEST_ASSERT_EQUAL(0, decrypted.length());
+    TEST_ASSERT_LESS_THAN_UINT32(REJECT_BUDGET_US, m.elapsed_us);
+    TEST_ASSERT_LESS_THAN_INT32(RETAINED_BUDGET_BYTES, m.retained_bytes);
+}
+
+void test_largest_nip44_payload_is_bounded() {
+    // Version 2, 65535-byte pad limit: decoded, MAC checked and rejected
+    String payload = randomBase64(NIP44_MAX_PAYLOAD_LENGTH / 4 * 3, 2);
+    TEST_ASSERT_EQUAL(NIP44_MAX_PAYLOAD_LENGTH, payload.length());
+    String decrypted;
+    Measurement m = measure("nip44 at pad limit", [&]() { decrypted = decryptMessageNip44(payload, SHARED_SECRET); });
+    TEST_ASSERT_EQUAL(0, decrypted.length());
+    TEST_ASSERT_LESS_THAN_UINT32(NIP44_WORST_BUDGET_US, m.elapsed_us);
+    TEST_ASSERT_LESS_THAN_INT32(RETAINED_BUDGET_BYTES, m.retained_bytes);
+}
+
+void setup() {
+    delay(2000); // Let the serial monitor attach
+    nostr::initMemorySpace(EVENT_DOC_SIZE, MESSAGE_BIN_SIZE);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_deeply_nested_tags_are_rejected);
+    RUN_TEST(test_oversized_nip04_iv_is_rejected);
+    RUN_TEST(test_oversized_nip04_ciphertext_is_rejected);
+    RUN_TEST(test_largest_admitted_nip04_ciphertext_is_bounded);
+    RUN_TEST(test_oversized_nip44_payload_is_rejected);
+    RUN_TEST(test_largest_nip44_payload_is_bounded);
+    UNITY_END();
+}
+
+void loop() {
+}